@@ -0,0 +1,54 @@
+'''
+  Plots the speedup and the efficiency against the number of threads, for
+  every trainer and kind of scaling in scaling.csv (see scaling_bench.py).
+'''
+
+
+from __future__ import print_function
+import csv
+import sys
+import matplotlib.pyplot as plt
+
+###########################################################################
+
+# Load the results
+
+file_name=sys.argv[1] if len(sys.argv)>1 else 'scaling.csv'
+
+series={}
+with open(file_name, 'r') as file:
+    reader = csv.DictReader(file)
+    for row in reader:
+        key=(row['program'],row['scaling'])
+        series.setdefault(key,[])
+        series[key]+=[(int(row['threads']),float(row['speedup']),float(row['efficiency']))]
+
+###########################################################################
+
+# Speedup and efficiency
+
+fig,(ax_speedup,ax_efficiency)=plt.subplots(1,2,figsize=(10,4),dpi=80)
+max_threads=1
+for (program,scaling),points in sorted(series.items()):
+    points.sort()
+    threads=[p[0] for p in points]
+    max_threads=max(max_threads,max(threads))
+    label="{} ({})".format(program,scaling)
+    ax_speedup.plot(threads,[p[1] for p in points],marker='o',label=label)
+    ax_efficiency.plot(threads,[p[2] for p in points],marker='o',label=label)
+# ideal scaling
+ax_speedup.plot([1,max_threads],[1,max_threads],'k--',label="ideal")
+ax_speedup.set_xlabel("threads")
+ax_speedup.set_ylabel("speedup")
+ax_speedup.legend(loc='upper left')
+ax_speedup.grid()
+ax_efficiency.set_xlabel("threads")
+ax_efficiency.set_ylabel("efficiency")
+ax_efficiency.set_ylim(0,1.1)
+ax_efficiency.grid()
+plt.tight_layout()
+plt.show()
+fig.savefig("scaling.pdf",\
+                    dpi=80, facecolor='w', edgecolor='w',\
+                    orientation='portrait', format=None,\
+                    transparent=False, bbox_inches=None, pad_inches=0.1)
@@ -0,0 +1,163 @@
+/********************************************************************************
+ 
+ Micro-benchmarks of the hot paths of the hold'em trainer: hand ranking
+ (one hand at a time with either evaluator, and in batches), dealing, the
+ strategy index of a pair of hole cards, and a full round of Regret::poker().
+ 
+ BM_batch compares the two parallel modes of the sampled training on one
+ batch of rounds: sharded tables merged at the end, and hogwild updates of
+ shared atomic tables. It uses all the OpenMP threads (OMP_NUM_THREADS).
+ 
+ ********************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <time.h>
+#include <sstream>
+#include <fstream>
+#include <unordered_map>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <omp.h>
+#include <benchmark/benchmark.h>
+#include "Rng.h"
+#include "Deck.h"
+#include "RankTable.h"
+#include "CheckRank.h"
+#include "Game.h"
+#include "AtomicGame.h"
+#include "Equity.h"
+#include "BestResponse.h"
+#include "Profiler.h"
+#include "CheckpointWriter.h"
+#include "Regret.h"
+
+using namespace std;
+
+// Random 7-card deals, in the layout of Regret::play_shard(): cards[k*n+i]
+// is the k-th card of deal i.
+static vector<int> deal_hands(int n){
+    Rng rng(12345);
+    Deck deck(rng);
+    vector<int> cards(7*n);
+    for(int i=0;i<n;++i){
+        deck.reset();
+        for(int k=0;k<7;++k)
+            cards[k*n+i]=deck.deal_card();
+    }
+    return cards;
+}
+
+static CheckRank & checkrank(){
+    static CheckRank c;
+    return c;
+}
+
+// One call of findRank per hand; the argument selects the evaluator.
+static void BM_findRank(benchmark::State & state){
+    CheckRank & c=checkrank();
+    c.set_evaluator(state.range(0)==0 ? CheckRank::Evaluator::hash_map : CheckRank::Evaluator::lookup_table);
+    const int n=1024;
+    vector<int> cards=deal_hands(n);
+    int i=0;
+    for(auto _ : state){
+        array<int,5> hand={cards[i],cards[n+i],cards[4*n+i],cards[5*n+i],cards[6*n+i]};
+        benchmark::DoNotOptimize(c.findRank(hand));
+        i=(i+1)%n;
+    }
+    c.set_evaluator(CheckRank::Evaluator::lookup_table);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_findRank)->Arg(0)->Arg(1);
+
+// Batches of hands ranked with one findRanks call.
+static void BM_findRanks(benchmark::State & state){
+    CheckRank & c=checkrank();
+    const int n=state.range(0);
+    vector<int> cards=deal_hands(n);
+    vector<int> ranks(n);
+    const int * hands[5]={&cards[0],&cards[n],&cards[4*n],&cards[5*n],&cards[6*n]};
+    for(auto _ : state){
+        c.findRanks(hands,n,ranks.data());
+        benchmark::DoNotOptimize(ranks.data());
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_findRanks)->Arg(64)->Arg(1024);
+
+// The seven cards of a round.
+static void BM_deal_card(benchmark::State & state){
+    Rng rng(12345);
+    Deck deck(rng);
+    for(auto _ : state){
+        deck.reset();
+        for(int k=0;k<7;++k)
+            benchmark::DoNotOptimize(deck.deal_card());
+    }
+    state.SetItemsProcessed(state.iterations()*7);
+}
+BENCHMARK(BM_deal_card);
+
+static void BM_strategy_index(benchmark::State & state){
+    Game game;
+    const int n=1024;
+    vector<int> cards=deal_hands(n);
+    int i=0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(game.strategy_index(cards[i],cards[n+i]));
+        i=(i+1)%n;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_strategy_index);
+
+// A full round: deal, rank, regret update and bankroll play.
+static void BM_poker(benchmark::State & state){
+    Regret regret(10000,1,2,1,1,12345);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(regret.poker());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_poker);
+
+// One batch of 65536 rounds; the argument selects the parallel mode.
+static void BM_batch(benchmark::State & state){
+    const int rounds=65536;
+    Regret regret(10000,rounds,2,1,1,12345);
+    regret.set_parallelism(state.range(0)==0 ? Regret::Parallelism::sharded : Regret::Parallelism::hogwild);
+    for(auto _ : state)
+        regret.run_batch();
+    state.SetItemsProcessed(state.iterations()*rounds);
+    // rounds per second of the slowest thread in the last batch
+    double slowest=0;
+    for(const Regret::ThreadStats & t : regret.get_thread_stats()){
+        double r=t.seconds>0 ? t.rounds/t.seconds : 0;
+        slowest=slowest==0 ? r : min(slowest,r);
+    }
+    state.counters["threads"]=regret.get_thread_stats().size();
+    state.counters["slowest_thread_rounds_per_second"]=slowest;
+}
+BENCHMARK(BM_batch)->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
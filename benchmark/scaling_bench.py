@@ -0,0 +1,147 @@
+'''
+  Thread-scaling benchmark of the parallel trainers.
+
+  Runs the hold'em trainer (kuhn_parallel) and the RPS trainer (rps_parallel)
+  at several thread counts, for a fixed total amount of work (strong scaling)
+  and for a fixed amount of work per thread (weak scaling), and writes one
+  line per run to a CSV file (scaling.csv by default) with the throughput,
+  speedup, efficiency and quality of the strategies. Plot_scaling.py plots
+  the file.
+
+  Usage: python3 scaling_bench.py --build-dir ../build [--threads 1,2,4,8]
+
+  The trainers are run with their command line settings and their JSON
+  summaries are read back. The speedup is the throughput at t threads over
+  the throughput at 1 thread, and the efficiency is the speedup over t; for
+  weak scaling this is the scaled speedup. Each point is the median of
+  --repeats runs.
+
+  Quality is the exploitability of the average strategies: computed exactly
+  by the hold'em trainer at the end of the run, and from the final
+  strategies of the two players for RPS. The time of the exploitability
+  check and of the I/O is not counted in the hold'em throughput.
+'''
+
+
+from __future__ import print_function
+import argparse
+import csv
+import json
+import os
+import statistics
+import subprocess
+import sys
+
+###########################################################################
+
+# Settings
+
+parser=argparse.ArgumentParser(description="Strong and weak thread scaling of the CFR trainers")
+parser.add_argument("--build-dir",default="build",help="directory of kuhn_parallel and rps_parallel")
+parser.add_argument("--threads",default="",help="comma-separated thread counts (default: powers of 2 up to the number of cores)")
+parser.add_argument("--programs",default="kuhn,rps",help="comma-separated list of kuhn and rps")
+parser.add_argument("--scaling",default="strong,weak",help="comma-separated list of strong and weak")
+parser.add_argument("--kuhn-rounds",type=int,default=1000000,help="hold'em rounds per batch at 1 thread")
+parser.add_argument("--kuhn-batches",type=int,default=10,help="hold'em batches")
+parser.add_argument("--kuhn-parallel",default="sharded",help="hold'em parallel mode: sharded or hogwild")
+parser.add_argument("--rps-iterations",type=int,default=1000000,help="RPS iterations at 1 thread")
+parser.add_argument("--repeats",type=int,default=3,help="runs per point, the median is kept")
+parser.add_argument("--seed",type=int,default=1,help="seed of the runs")
+parser.add_argument("--work-dir",default="scaling_runs",help="directory of the outputs of the runs")
+parser.add_argument("--output",default="scaling.csv",help="CSV file of the results")
+args=parser.parse_args()
+
+if args.threads:
+    thread_counts=[int(t) for t in args.threads.split(",")]
+else:
+    cores=os.cpu_count() or 1
+    thread_counts=[]
+    t=1
+    while t<cores:
+        thread_counts+=[t]
+        t*=2
+    thread_counts+=[cores]
+
+if not os.path.isdir(args.work_dir):
+    os.makedirs(args.work_dir)
+# the equity table is computed by the first hold'em run and reused
+equity_file=os.path.abspath(os.path.join(args.work_dir,"equity.bin"))
+
+###########################################################################
+
+# Runs
+
+def run(command):
+    result=subprocess.run(command,stdout=subprocess.PIPE,stderr=subprocess.STDOUT,universal_newlines=True)
+    if result.returncode!=0:
+        print(result.stdout)
+        sys.exit("{} failed".format(" ".join(command)))
+
+def run_kuhn(threads,rounds):
+    out=os.path.join(args.work_dir,"kuhn_{}_{}".format(threads,rounds))
+    run([os.path.join(args.build_dir,"kuhn_parallel"),
+         "--threads",str(threads),"--rounds",str(rounds),"--batches",str(args.kuhn_batches),
+         "--seed",str(args.seed),"--parallel",args.kuhn_parallel,
+         "--check-every",str(args.kuhn_batches),"--checkpoint-every","0",
+         "--equity-file",equity_file,"--output-dir",out])
+    with open(os.path.join(out,"summary.json"),"r") as file:
+        summary=json.load(file)
+    # training time only: the I/O and the exploitability check run on thread 0
+    profile=summary["profile"]
+    io=profile["phases"].index("io")
+    check=profile["phases"].index("exploitability")
+    seconds=summary["wall_seconds"]-profile["thread_seconds"][0][io]-profile["thread_seconds"][0][check]
+    work=summary["rounds_per_batch"]*summary["batches"]
+    return work,seconds,summary["exploitability"]
+
+# exploitability of the RPS strategies x and y: what each player would gain
+# by a best response against the other (the game value is 0)
+def rps_exploitability(x,y):
+    def best_response(s):
+        # payoffs of rock, paper and scissors against the strategy s
+        return max(s[2]-s[1],s[0]-s[2],s[1]-s[0])
+    return (best_response(y)+best_response(x))/2
+
+def run_rps(threads,iterations):
+    summary_file=os.path.join(args.work_dir,"rps_{}_{}.json".format(threads,iterations))
+    run([os.path.join(args.build_dir,"rps_parallel"),
+         "--threads",str(threads),"--iterations",str(iterations),
+         "--seed",str(args.seed),"--summary",summary_file])
+    with open(summary_file,"r") as file:
+        summary=json.load(file)
+    # both trainings run "iterations" iterations
+    work=2*summary["iterations"]
+    return work,summary["wall_seconds"],rps_exploitability(summary["nash_strategy_1"],summary["nash_strategy_2"])
+
+programs={"kuhn":(run_kuhn,args.kuhn_rounds),"rps":(run_rps,args.rps_iterations)}
+
+###########################################################################
+
+# Scaling
+
+rows=[]
+for program in args.programs.split(","):
+    runner,base=programs[program]
+    for scaling in args.scaling.split(","):
+        base_rate=None
+        for threads in thread_counts:
+            size=base*threads if scaling=="weak" else base
+            results=[runner(threads,size) for r in range(args.repeats)]
+            seconds=statistics.median([r[1] for r in results])
+            work=results[0][0]
+            quality=statistics.median([r[2] for r in results])
+            rate=work/seconds if seconds>0 else 0
+            if base_rate is None:
+                base_rate=rate
+            speedup=rate/base_rate if base_rate>0 else 0
+            rows+=[{"program":program,"scaling":scaling,"threads":threads,"work":work,
+                    "seconds":seconds,"rate":rate,"speedup":speedup,
+                    "efficiency":speedup/threads,"exploitability":quality}]
+            print("{} {} threads={} work={} seconds={:.4f} rate={:.4g} speedup={:.3f} efficiency={:.3f} exploitability={:.4g}"
+                  .format(program,scaling,threads,work,seconds,rate,speedup,speedup/threads,quality))
+
+with open(args.output,"w") as file:
+    writer=csv.DictWriter(file,fieldnames=["program","scaling","threads","work","seconds","rate","speedup","efficiency","exploitability"])
+    writer.writeheader()
+    writer.writerows(rows)
+print("Results written to {}".format(args.output))
@@ -0,0 +1,198 @@
+/********************************************************************************
+ 
+ Settings of a run, read from command line flags and from a config file, so
+ that a run never waits on the terminal.
+ 
+ Every setting is declared with add(), with its default value and a help
+ line. On the command line a setting is given as "--name value" (or just
+ "--name" for a yes/no setting), and "--config file" reads more settings
+ from a file with one "name = value" per line ("#" starts a comment).
+ Settings given on the command line win over those of the config file,
+ whatever their order. Numbers are checked when they are read, so that a
+ typo stops the run before it starts: an integer must fit in a long long,
+ and in the range given with set_range() when the program narrows it (to
+ an int, or to a positive count).
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class Config{
+    
+public:
+    
+    enum class Kind { integer, real, text, flag };
+    
+    void add(const string & name, Kind kind, const string & value, const string & help){
+        options[name]={kind,value,help,false,LLONG_MIN,LLONG_MAX};
+        order.push_back(name);
+    }
+    
+    // Valid values of the integer setting "name", bounds included.
+    void set_range(const string & name, long long min, long long max){
+        options.at(name).min=min;
+        options.at(name).max=max;
+    }
+    
+    // Read the command line. Returns false, after printing why, if a
+    // setting is unknown or has an invalid value, or if --help is given.
+    bool parse(int argc, char ** argv){
+        string program=argc>0 ? argv[0] : "";
+        vector<pair<string,string>> given;
+        string config_file;
+        for(int i=1;i<argc;++i){
+            string arg=argv[i];
+            if(arg=="--help"||arg=="-h"){
+                usage(program);
+                return false;
+            }
+            if(arg.compare(0,2,"--")!=0){
+                cout << "Unexpected argument " << arg << endl;
+                usage(program);
+                return false;
+            }
+            string name=arg.substr(2), value;
+            size_t eq=name.find('=');
+            if(eq!=string::npos){
+                value=name.substr(eq+1);
+                name=name.substr(0,eq);
+            }
+            else if(options.count(name)&&options[name].kind==Kind::flag)
+                value="1";
+            else if(i+1<argc)
+                value=argv[++i];
+            else{
+                cout << "Missing value for --" << name << endl;
+                return false;
+            }
+            if(name=="config")
+                config_file=value;
+            else
+                given.push_back({name,value});
+        }
+        if(!config_file.empty()&&!read_file(config_file))
+            return false;
+        for(auto & g : given)
+            if(!set(g.first,g.second,"command line"))
+                return false;
+        return true;
+    }
+    
+    bool has(const string & name){
+        return options.count(name)&&options[name].set;
+    }
+    
+    string get_string(const string & name){
+        return options.at(name).value;
+    }
+    
+    long long get_int(const string & name){
+        return stoll(options.at(name).value);
+    }
+    
+    double get_double(const string & name){
+        return stod(options.at(name).value);
+    }
+    
+    bool get_flag(const string & name){
+        string v=options.at(name).value;
+        return v=="1"||v=="true"||v=="yes"||v=="on";
+    }
+    
+    void usage(const string & program){
+        cout << "Usage: " << program << " [--config file] [--name value]..." << endl;
+        for(const string & name : order){
+            Option & o=options[name];
+            cout << "  --" << name;
+            if(o.kind!=Kind::flag)
+                cout << " <" << (o.kind==Kind::text ? "text" : "number") << ">";
+            cout << "  " << o.help;
+            if(!o.value.empty()&&o.kind!=Kind::flag)
+                cout << " (default " << o.value << ")";
+            cout << endl;
+        }
+    }
+    
+private:
+    
+    struct Option{
+        Kind kind;
+        string value;
+        string help;
+        bool set;
+        long long min, max; // range of an integer
+    };
+    
+    bool read_file(const string & file){
+        ifstream is(file);
+        if(!is){
+            cout << "Cannot open config file " << file << endl;
+            return false;
+        }
+        string line;
+        int number=0;
+        while(getline(is,line)){
+            ++number;
+            line=line.substr(0,line.find('#'));
+            size_t eq=line.find('=');
+            string name=trim(eq==string::npos ? line : line.substr(0,eq));
+            string value=eq==string::npos ? "" : trim(line.substr(eq+1));
+            if(name.empty())
+                continue;
+            if(eq==string::npos&&options.count(name)&&options[name].kind==Kind::flag)
+                value="1";
+            if(!set(name,value,file+":"+to_string(number)))
+                return false;
+        }
+        return true;
+    }
+    
+    bool set(const string & name, const string & value, const string & where){
+        if(!options.count(name)){
+            cout << "Unknown setting \"" << name << "\" (" << where << ")" << endl;
+            return false;
+        }
+        Option & o=options[name];
+        if(!valid(o,value)){
+            cout << "Invalid value \"" << value << "\" for " << name << " (" << where << ")";
+            if(o.kind==Kind::integer&&(o.min!=LLONG_MIN||o.max!=LLONG_MAX))
+                cout << ", expected an integer from " << o.min << " to " << o.max;
+            cout << endl;
+            return false;
+        }
+        o.value=value;
+        o.set=true;
+        return true;
+    }
+    
+    // Whether get_int() or get_double() can read "value" (strtoll and
+    // strtod set errno to ERANGE where stoll and stod would throw).
+    static bool valid(const Option & o, const string & value){
+        if(o.kind==Kind::text)
+            return true;
+        if(o.kind==Kind::flag)
+            return value=="0"||value=="1"||value=="true"||value=="false"||value=="yes"||value=="no"||value=="on"||value=="off";
+        if(value.empty())
+            return false;
+        char * end;
+        errno=0;
+        if(o.kind==Kind::integer){
+            long long v=strtoll(value.c_str(),&end,10);
+            return *end=='\0'&&errno!=ERANGE&&v>=o.min&&v<=o.max;
+        }
+        strtod(value.c_str(),&end);
+        return *end=='\0'&&errno!=ERANGE;
+    }
+    
+    static string trim(const string & s){
+        size_t a=s.find_first_not_of(" \t\r");
+        if(a==string::npos)
+            return "";
+        size_t b=s.find_last_not_of(" \t\r");
+        return s.substr(a,b-a+1);
+    }
+    
+    map<string,Option> options;
+    vector<string> order;
+    
+};
@@ -0,0 +1,144 @@
+/********************************************************************************
+ 
+ Wall-clock instrumentation of a run: time spent and work done in each phase
+ (dealing, ranking, ...), per thread.
+ 
+ The phases are named when the Profiler is made. A Timer measures one phase
+ with steady_clock from its construction to its destruction and adds the
+ time, one call and a count of items (rounds, hands, ...) to the counters of
+ its thread. Every thread has its own 64-byte aligned counters, so the timers
+ of different threads never share a cache line and need no lock; reserve()
+ makes room for the threads before a parallel region. The background row is
+ for a thread outside of the OpenMP team, such as the checkpoint writer.
+ 
+ The timers are meant for coarse blocks of work (a block of rounds, a whole
+ reduction), not for single rounds: a steady_clock reading costs about as
+ much as dealing a card.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class Profiler{
+    
+public:
+    
+    static const int max_phases=8;
+    
+    struct alignas(64) Counters{
+        double seconds[max_phases]={};
+        long long calls[max_phases]={};
+        long long items[max_phases]={};
+    };
+    
+    class Timer{
+        
+    public:
+        
+        Timer(Profiler & p, int thread, int phase, long long items=0){
+            counters=&p.row(thread);
+            this->phase=phase;
+            this->items=items;
+            start=chrono::steady_clock::now();
+        }
+        
+        ~Timer(){
+            counters->seconds[phase]+=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+            counters->calls[phase]+=1;
+            counters->items[phase]+=items;
+        }
+        
+        Timer(const Timer &)=delete;
+        Timer & operator=(const Timer &)=delete;
+        
+    private:
+        
+        Counters * counters;
+        int phase;
+        long long items;
+        chrono::steady_clock::time_point start;
+        
+    };
+    
+    Profiler(const vector<string> & names){
+        phase_names=names;
+        threads.resize(1);
+    }
+    
+    // Make room for threads 0..n-1; call outside of parallel regions.
+    void reserve(int n){
+        if(n>(int) threads.size())
+            threads.resize(n);
+    }
+    
+    // Counters of OpenMP thread "thread", or of the background thread if
+    // "thread" is background.
+    Counters & row(int thread){
+        return thread==background ? background_counters : threads[thread];
+    }
+    
+    // Time of "phase" summed over all threads.
+    double seconds(int phase){
+        double s=background_counters.seconds[phase];
+        for(Counters & c : threads)
+            s+=c.seconds[phase];
+        return s;
+    }
+    
+    int phases(){
+        return phase_names.size();
+    }
+    
+    const string & name(int phase){
+        return phase_names[phase];
+    }
+    
+    // One line per thread and phase that was timed.
+    bool write_csv(const string & file){
+        ofstream os(file);
+        os << "thread,phase,calls,items,seconds" << endl;
+        for(int t=0;t<=(int) threads.size();++t){
+            bool last=t==(int) threads.size();
+            Counters & c=last ? background_counters : threads[t];
+            for(int p=0;p<phases();++p)
+                if(c.calls[p]>0)
+                    os << (last ? string("background") : to_string(t)) << "," << phase_names[p] << ","
+                       << c.calls[p] << "," << c.items[p] << "," << c.seconds[p] << endl;
+        }
+        os.close();
+        return (bool) os;
+    }
+    
+    // JSON object with the phase names, the total seconds of every phase,
+    // and the seconds of every phase by thread (background last).
+    void write_json(ostream & os, const string & indent){
+        os << "{" << endl;
+        os << indent << "  \"phases\": [";
+        for(int p=0;p<phases();++p)
+            os << (p>0 ? ", " : "") << "\"" << phase_names[p] << "\"";
+        os << "]," << endl;
+        os << indent << "  \"seconds\": [";
+        for(int p=0;p<phases();++p)
+            os << (p>0 ? ", " : "") << seconds(p);
+        os << "]," << endl;
+        os << indent << "  \"thread_seconds\": [";
+        for(int t=0;t<=(int) threads.size();++t){
+            Counters & c=t==(int) threads.size() ? background_counters : threads[t];
+            os << (t>0 ? ", " : "") << "[";
+            for(int p=0;p<phases();++p)
+                os << (p>0 ? ", " : "") << c.seconds[p];
+            os << "]";
+        }
+        os << "]" << endl;
+        os << indent << "}";
+    }
+    
+    static const int background=-1;
+    
+private:
+    
+    vector<string> phase_names;
+    vector<Counters> threads;
+    Counters background_counters;
+    
+};
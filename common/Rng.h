@@ -0,0 +1,96 @@
+/********************************************************************************
+ 
+ Seedable random number generator (xoshiro256**, by Blackman and Vigna).
+ 
+ The state is four 64-bit words, initialized from the seed with splitmix64.
+ An Rng is cheap to copy and is not shared between threads: each thread gets
+ its own generator, seeded with the run seed and its own stream number, so
+ that a run is reproducible from a single seed.
+ 
+ Link to paper: https://prng.di.unimi.it
+ ********************************************************************************/
+
+using namespace std;
+
+class Rng{
+    
+public:
+    
+    typedef unsigned long long result_type;
+    
+    Rng(){
+        seed(0,0);
+    }
+    
+    Rng(result_type s){
+        seed(s,0);
+    }
+    
+    // Generator number "stream" of the run seeded with "s".
+    Rng(result_type s, result_type stream){
+        seed(s,stream);
+    }
+    
+    void seed(result_type s, result_type stream){
+        result_type x=s^(stream*0xD1B54A32D192ED03ULL);
+        for(int i=0;i<4;++i)
+            state[i]=splitmix64(x);
+    }
+    
+    result_type operator()(){
+        result_type result=rotl(state[1]*5,7)*9;
+        result_type t=state[1]<<17;
+        state[2]^=state[0];
+        state[3]^=state[1];
+        state[1]^=state[2];
+        state[0]^=state[3];
+        state[2]^=t;
+        state[3]=rotl(state[3],45);
+        return result;
+    }
+    
+    // Uniform double in [0,1).
+    double uniform(){
+        return ((*this)()>>11)*0x1.0p-53;
+    }
+    
+    // Uniform integer in [0,n), using the multiply-shift method instead of
+    // a division (the bias is below n/2^32).
+    int below(int n){
+        return (int) ((((*this)()>>32)*(result_type) n)>>32);
+    }
+    
+    static constexpr result_type min(){
+        return 0;
+    }
+    
+    static constexpr result_type max(){
+        return ~(result_type) 0;
+    }
+    
+    // Interface to the state, used to save and restore a run.
+    
+    array<result_type,4> get_state(){
+        return state;
+    }
+    
+    void set_state(const array<result_type,4> & s){
+        state=s;
+    }
+    
+private:
+    
+    static result_type rotl(result_type x, int k){
+        return (x<<k)|(x>>(64-k));
+    }
+    
+    static result_type splitmix64(result_type & x){
+        result_type z=(x+=0x9E3779B97F4A7C15ULL);
+        z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+        z=(z^(z>>27))*0x94D049BB133111EBULL;
+        return z^(z>>31);
+    }
+    
+    array<result_type,4> state;
+    
+};
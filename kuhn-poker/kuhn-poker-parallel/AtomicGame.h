@@ -0,0 +1,142 @@
+/********************************************************************************
+ 
+ Regret and strategy tables shared by all threads, for the hogwild mode of
+ Regret: the threads play rounds concurrently and add their regret and
+ strategy-sum deltas straight into the same tables, without shards and
+ without locks.
+ 
+ Every hand has its own 64-byte slot, so that two threads updating different
+ hands never write to the same cache line. The entries are atomic doubles,
+ updated with relaxed compare-and-swap additions, and the CFR+ floor is a
+ compare-and-swap too, so no update is lost; but the
+ order of the additions, and hence the rounding of the sums, depends on the
+ scheduling of the threads, so a run is not bit-reproducible.
+ 
+ An AtomicSeat is the view of one thread on an AtomicTable. It has the same
+ interface as Game for the training loop of Regret, and keeps the bankroll
+ of the thread privately.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class AtomicTable{
+    
+public:
+    
+    struct alignas(64) Slot{
+        atomic<double> regret_sum[2];
+        atomic<double> strategy_sum[2];
+        atomic<double> strategy;
+    };
+    
+    // Copy the tables of "game" into the slots.
+    void load(Game & game){
+        for(int k=0;k<169;++k){
+            for(int a=0;a<2;++a){
+                slots[k].regret_sum[a].store(game.get_regret_sum(k,a),memory_order_relaxed);
+                slots[k].strategy_sum[a].store(game.get_strategy_sum(k,a),memory_order_relaxed);
+            }
+            slots[k].strategy.store(game.get_strategy(k),memory_order_relaxed);
+        }
+    }
+    
+    // Copy the slots back into "game".
+    void store(Game & game){
+        for(int k=0;k<169;++k){
+            game.set_regret_sum(k,get(slots[k].regret_sum[0]),get(slots[k].regret_sum[1]));
+            game.set_strategy_sum(k,get(slots[k].strategy_sum[0]),get(slots[k].strategy_sum[1]));
+            game.set_strategy(k,get(slots[k].strategy));
+        }
+    }
+    
+    static double get(const atomic<double> & x){
+        return x.load(memory_order_relaxed);
+    }
+    
+    static void set(atomic<double> & x, double v){
+        x.store(v,memory_order_relaxed);
+    }
+    
+    // x+=d without losing concurrent additions.
+    static void add(atomic<double> & x, double d){
+        double old=x.load(memory_order_relaxed);
+        while(!x.compare_exchange_weak(old,old+d,memory_order_relaxed,memory_order_relaxed));
+    }
+    
+    // x=max(x,0) without losing concurrent additions: the zero is only
+    // stored if x is still the negative value that was read.
+    static void floor(atomic<double> & x){
+        double old=x.load(memory_order_relaxed);
+        while(old<0&&!x.compare_exchange_weak(old,0.0,memory_order_relaxed,memory_order_relaxed));
+    }
+    
+    Slot & operator[](int k){
+        return slots[k];
+    }
+    
+private:
+    
+    Slot slots[169];
+    
+};
+
+class AtomicSeat{
+    
+public:
+    
+    AtomicSeat(AtomicTable & t){
+        table=&t;
+        bankroll=0;
+    }
+    
+    double get_strategy(const int & k){
+        return AtomicTable::get((*table)[k].strategy);
+    }
+    
+    void set_strategy(const int & k, const double & p){
+        AtomicTable::set((*table)[k].strategy,p);
+    }
+    
+    double get_regret_sum(const int & k, const int & a){
+        return AtomicTable::get((*table)[k].regret_sum[a]);
+    }
+    
+    void set_regret_sum(const int & k, const double & r0, const double & r1){
+        AtomicTable::set((*table)[k].regret_sum[0],r0);
+        AtomicTable::set((*table)[k].regret_sum[1],r1);
+    }
+    
+    void add_regret_sum(const int & k, const double & r0, const double & r1){
+        AtomicTable::add((*table)[k].regret_sum[0],r0);
+        AtomicTable::add((*table)[k].regret_sum[1],r1);
+    }
+    
+    void floor_regret_sum(const int & k){
+        AtomicTable::floor((*table)[k].regret_sum[0]);
+        AtomicTable::floor((*table)[k].regret_sum[1]);
+    }
+    
+    void add_strategy_sum(const int & k, const double & s0, const double & s1){
+        AtomicTable::add((*table)[k].strategy_sum[0],s0);
+        AtomicTable::add((*table)[k].strategy_sum[1],s1);
+    }
+    
+    bool act(const int & k, Rng & rng){
+        return rng.uniform()<get_strategy(k); // act (bet or call)
+    }
+    
+    void change_bankroll(const double & b){
+        bankroll+=b;
+    }
+    
+    double get_bankroll(){
+        return bankroll;
+    }
+    
+private:
+    
+    AtomicTable * table;
+    double bankroll;
+    
+};
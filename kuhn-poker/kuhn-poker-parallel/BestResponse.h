@@ -0,0 +1,97 @@
+/********************************************************************************
+ 
+ Best responses to the strategies of Player and Dealer, and the exploitability
+ of a pair of strategies, computed exactly from the equities of Equity.h.
+ 
+ Player's best response to a calling strategy q bets with each class when
+ betting is worth more than checking, and Dealer's best response to a betting
+ strategy p calls when calling is worth more than folding. All values are
+ expected values of one round, weighted by the probability of the deal.
+ 
+ The game value v satisfies best_player_value(q) >= v >= -best_dealer_value(p),
+ so nash_conv(p,q) = best_player_value(q)+best_dealer_value(p) is zero exactly
+ at an equilibrium. The exploitability is half of it: how much a best
+ responder wins on average over both seats, compared with the equilibrium.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class BestResponse{
+    
+public:
+    
+    BestResponse(Equity & e, double Ante, double Bet) : equity(e){
+        ante=Ante;
+        bet=Bet;
+    }
+    
+    // Expected value of a round for Player when Player bets with
+    // probabilities p and Dealer calls with probabilities q.
+    double player_value(const Game::Table & p, const Game::Table & q){
+        Game::Table bet_value, check_value;
+        equity.player_values(q,ante,bet,bet_value,check_value);
+        double value=0;
+        for(int i=0;i<169;++i)
+            value+=p[i]*bet_value[i]+(1-p[i])*check_value[i];
+        return value;
+    }
+    
+    // Expected value for Player of a best response to q.
+    double best_player_value(const Game::Table & q){
+        Game::Table bet_value, check_value;
+        equity.player_values(q,ante,bet,bet_value,check_value);
+        double value=0;
+        for(int i=0;i<169;++i)
+            value+=max(bet_value[i],check_value[i]);
+        return value;
+    }
+    
+    // Expected value for Dealer of a best response to p. The values of
+    // Equity::dealer_values() only cover the rounds where Player bets, the
+    // showdowns after Player checks are added here.
+    double best_dealer_value(const Game::Table & p){
+        Game::Table call_value, fold_value;
+        equity.dealer_values(p,ante,bet,call_value,fold_value);
+        double value=0;
+        for(int j=0;j<169;++j)
+            value+=max(call_value[j],fold_value[j]);
+        for(int i=0;i<169;++i)
+            for(int j=0;j<169;++j)
+                value-=(1-p[i])*ante*equity.get_weight(i,j)*(2*equity.get_win(i,j)+equity.get_tie(i,j)-1);
+        return value;
+    }
+    
+    // Player's best response to q: 1 to bet, 0 to check.
+    Game::Table best_player_strategy(const Game::Table & q){
+        Game::Table bet_value, check_value, strategy;
+        equity.player_values(q,ante,bet,bet_value,check_value);
+        for(int i=0;i<169;++i)
+            strategy[i]=bet_value[i]>check_value[i] ? 1 : 0;
+        return strategy;
+    }
+    
+    // Dealer's best response to p: 1 to call, 0 to fold.
+    Game::Table best_dealer_strategy(const Game::Table & p){
+        Game::Table call_value, fold_value, strategy;
+        equity.dealer_values(p,ante,bet,call_value,fold_value);
+        for(int j=0;j<169;++j)
+            strategy[j]=call_value[j]>fold_value[j] ? 1 : 0;
+        return strategy;
+    }
+    
+    double nash_conv(const Game::Table & p, const Game::Table & q){
+        return best_player_value(q)+best_dealer_value(p);
+    }
+    
+    double exploitability(const Game::Table & p, const Game::Table & q){
+        return nash_conv(p,q)/2;
+    }
+    
+private:
+    
+    Equity & equity;
+    double ante;
+    double bet;
+    
+};
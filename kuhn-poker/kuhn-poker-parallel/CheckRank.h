@@ -6,80 +6,292 @@
  sorted in the decreasing order of rank, such as AATTT. Also notice that tens
  are represented as T, not 10.
  
+ Two evaluators are available behind findRank(). The hash_map evaluator looks
+ up the product of the card primes in a hash map. The lookup_table evaluator
+ (the default) does no hashing: flushes are read from a table indexed by the
+ 13-bit mask of their card ranks, and all other hands from a table indexed by
+ a perfect hash of the same prime product (two multiplications and a 1024-entry
+ displacement table, built once so that no two hands share a slot).
+ 
+ findRanks() ranks a whole batch of hands given in a structure-of-arrays
+ layout. With the lookup_table evaluator it ranks 8 hands at a time with AVX2
+ when the CPU supports it (checked once at run time), and falls back to the
+ scalar lookup otherwise.
+ 
+ The ranks are not read from ranks.csv at run time: the build converts it with
+ tools/make_rank_table into RankTable.h, a compact table compiled into the
+ program and checked against its checksum at compile time. All the tables are
+ built from it only once per process, by the first CheckRank.
+ 
  ********************************************************************************/
 
 using namespace std;
 
+#ifndef RANK_TABLE
+#error "RankTable.h must be included before CheckRank.h; it is generated from ranks.csv by tools/make_rank_table"
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKRANK_X86 1
+#else
+#define CHECKRANK_X86 0
+#endif
+
+// Compile-time codes of the card ranks.
+struct RankCodes{
+    
+    // Prime of a card rank character of ranks.csv (0 for any other character).
+    static constexpr int encode(char c){
+        switch(c){
+            case 'A': return 2;
+            case 'K': return 3;
+            case 'Q': return 5;
+            case 'J': return 7;
+            case 'T': return 11;
+            case '9': return 13;
+            case '8': return 17;
+            case '7': return 19;
+            case '6': return 23;
+            case '5': return 29;
+            case '4': return 31;
+            case '3': return 37;
+            case '2': return 41;
+            default: return 0;
+        }
+    }
+    
+    // Checksum of the words of RankTable (FNV-1a, as in make_rank_table).
+    static constexpr unsigned long long checksum(const unsigned * hands, int n){
+        unsigned long long h=0xCBF29CE484222325ULL;
+        for(int i=0;i<n;++i){
+            h^=hands[i];
+            h*=0x100000001B3ULL;
+        }
+        return h;
+    }
+    
+    // Bit of each card rank (A=1, K=2, ..., 2=4096), by prime.
+    static constexpr array<int,42> rank_bit(){
+        array<int,42> bits={};
+        const char ranks[]="AKQJT98765432";
+        for(int i=0;i<13;++i)
+            bits[encode(ranks[i])]=1<<i;
+        return bits;
+    }
+    
+};
+
 class CheckRank{
 public:
-    CheckRank(){
-        // the ranks loaded from ranks.csv will be encoded just once
-        // when the CheckRank object is initialized.
-        encode={{'A',2},{'K',3},{'Q',5},{'J',7},{'T',11},
-            {'9',13},{'8',17},{'7',19},{'6',23},{'5',29},
-            {'4',31},{'3',37},{'2',41}};
-        // ranks.csv is in the same directory as CheckRank.h; but CheckRank.h
-        // is called from ../Directory, from which the path to here is:
-        string file="ranks.csv";
-        ifstream is(file);
-        string str;
-        getline(is,str);
-        int i=0;
+    enum class Evaluator { hash_map, lookup_table };
+    
+    CheckRank(Evaluator e=Evaluator::lookup_table){
+        evaluator=e;
+        use_avx2=cpu_has_avx2();
+        // The tables are built by the first CheckRank of the process only;
+        // the others reuse them.
+        shared=&shared_tables();
+        flush_ranks=shared->flush_ranks;
+        non_flush_ranks=shared->non_flush_ranks;
+        displacement=shared->displacement;
+        hash_multiplier=shared->hash_multiplier;
+    }
+    
+    // Rank tables, built from RankTable once per process.
+    struct Tables{
+        vector<string> all_ranks;
+        unordered_map<int,int> flushes;
+        unordered_map<int,int> non_flushes;
+        array<unsigned short,8192> flush_ranks;
+        array<unsigned short,8193> non_flush_ranks;
+        array<int,1024> displacement;
+        unsigned hash_multiplier;
+    };
+    
+    static const Tables & shared_tables(){
+        static const Tables tables=load_tables();
+        return tables;
+    }
+    
+    static Tables load_tables(){
+        static_assert(RankTable::size==7462,"RankTable.h must list the 7462 distinct hands");
+        static_assert(RankCodes::checksum(RankTable::hands,RankTable::size)==RankTable::checksum,
+                      "RankTable.h is corrupted, regenerate it from ranks.csv with make_rank_table");
+        Tables t;
+        const char ranks[]="AKQJT98765432";
         // populate the all_ranks
-        while(i<str.size()){
-            int j=i;
-            string entry;
-            while(j<str.size()&&str[j]!=',')
-                ++j;
-            entry=str.substr(i,j-i);
-            all_ranks.push_back(entry);
-            i=j+1;
+        for(int i=0;i<RankTable::size;++i){
+            string hand(5,' ');
+            for(int k=0;k<5;++k)
+                hand[k]=ranks[(RankTable::hands[i]>>(4*k))&15];
+            t.all_ranks.push_back(hand);
         }
-        // Populate flushes map
-        for(int i=0;i<10;++i){
+        // Populate the flushes and non-flushes maps
+        for(int i=0;i<(int) t.all_ranks.size();++i){
             int rank=1;
-            for(char c : all_ranks[i]){
-                rank*=encode[c];
+            for(char c : t.all_ranks[i]){
+                rank*=RankCodes::encode(c);
             }
-            if(rank==0)
-                throw "Rank is zero!";
-            flushes[rank]=i;
+            if(i<10||(i>=322&&i<1599))
+                t.flushes[rank]=i;
+            else
+                t.non_flushes[rank]=i;
         }
-        for(int i=322;i<1599;++i){
-            int rank=1;
-            for(char c : all_ranks[i]){
-                rank*=encode[c];
+        build_tables(t);
+        return t;
+    }
+    
+    // Fill the tables of the lookup_table evaluator from all_ranks.
+    static void build_tables(Tables & t){
+        t.flush_ranks.fill(0);
+        vector<pair<unsigned,int>> products;
+        for(int i=0;i<(int) t.all_ranks.size();++i){
+            unsigned product=1;
+            int mask=0;
+            for(char c : t.all_ranks[i]){
+                product*=RankCodes::encode(c);
+                mask|=rank_bit[RankCodes::encode(c)];
             }
-            if(rank==0)
-                throw "Rank is zero!";
-            flushes[rank]=i;
+            if(i<10||(i>=322&&i<1599))
+                t.flush_ranks[mask]=i;
+            else
+                products.push_back({product,i});
         }
-        // Populate non-flushes map
-        for(int i=10;i<322;++i){
-            int rank=1;
-            for(char c : all_ranks[i]){
-                rank*=encode[c];
+        // Try other multipliers for the slot hash until a perfect one is found.
+        t.hash_multiplier=0x85EBCA77u;
+        while(!build_perfect_hash(t,products))
+            t.hash_multiplier+=0x6A09E667u;
+    }
+    
+    // Perfect hash of the non-flush prime products: each product falls in
+    // one of 1024 buckets, and all products of a bucket are moved to free
+    // slots by the same displacement, trying the largest buckets first.
+    static bool build_perfect_hash(Tables & t, const vector<pair<unsigned,int>> & products){
+        vector<vector<int>> buckets(1024);
+        for(int i=0;i<(int) products.size();++i)
+            buckets[bucket_of(products[i].first)].push_back(i);
+        vector<int> order(1024);
+        for(int b=0;b<1024;++b)
+            order[b]=b;
+        stable_sort(order.begin(),order.end(),[&](int a, int b){
+            return buckets[a].size()>buckets[b].size();
+        });
+        vector<bool> used(8192,false);
+        t.displacement.fill(0);
+        t.non_flush_ranks.fill(0);
+        for(int b : order){
+            bool placed=buckets[b].empty();
+            for(int d=0;d<8192&&!placed;++d){
+                vector<int> slots;
+                for(int i : buckets[b]){
+                    int slot=slot_of(products[i].first,t.hash_multiplier)^d;
+                    if(used[slot]||find(slots.begin(),slots.end(),slot)!=slots.end())
+                        break;
+                    slots.push_back(slot);
+                }
+                if(slots.size()<buckets[b].size())
+                    continue;
+                t.displacement[b]=d;
+                for(size_t k=0;k<slots.size();++k){
+                    used[slots[k]]=true;
+                    t.non_flush_ranks[slots[k]]=products[buckets[b][k]].second;
+                }
+                placed=true;
             }
-            if(rank==0)
-                throw "Rank is zero!";
-            non_flushes[rank]=i;
+            if(!placed)
+                return false;
         }
-        for(int i=1599;i<7462;++i){
-            int rank=1;
-            for(char c : all_ranks[i]){
-                rank*=encode[c];
+        return true;
+    }
+    
+    int findRank(const vector<int> & hand){
+        if(evaluator==Evaluator::lookup_table&&hand.size()==5)
+            return lookup_rank(hand.data());
+        return hash_rank(hand.data(),hand.size());
+    }
+    
+    int findRank(const array<int,5> & hand){
+        if(evaluator==Evaluator::lookup_table)
+            return lookup_rank(hand.data());
+        return hash_rank(hand.data(),5);
+    }
+    
+    // Rank of a 5-card hand read from the lookup tables.
+    int lookup_rank(const int * hand){
+        int suit=hand[0]&hand[1]&hand[2]&hand[3]&hand[4]&0xF00;
+        int p0=hand[0]&255, p1=hand[1]&255, p2=hand[2]&255, p3=hand[3]&255, p4=hand[4]&255;
+        if(suit>0)
+            return flush_ranks[rank_bit[p0]|rank_bit[p1]|rank_bit[p2]|rank_bit[p3]|rank_bit[p4]];
+        unsigned product=(unsigned) p0*p1*p2*p3*p4;
+        return non_flush_ranks[slot_of(product,hash_multiplier)^displacement[bucket_of(product)]];
+    }
+    
+    // Ranks of the n 5-card hands cards[0][i],...,cards[4][i], i=0...n-1,
+    // written to ranks[i].
+    void findRanks(const int * const cards[5], int n, int * ranks){
+        int i=0;
+        if(evaluator==Evaluator::lookup_table){
+#if CHECKRANK_X86
+            if(use_avx2)
+                i=lookup_ranks_avx2(cards,n,ranks);
+#endif
+            for(;i<n;++i){
+                int hand[5]={cards[0][i],cards[1][i],cards[2][i],cards[3][i],cards[4][i]};
+                ranks[i]=lookup_rank(hand);
+            }
+        }
+        else{
+            for(;i<n;++i){
+                int hand[5]={cards[0][i],cards[1][i],cards[2][i],cards[3][i],cards[4][i]};
+                ranks[i]=hash_rank(hand,5);
             }
-            if(rank==0)
-                throw "Rank is zero!";
-            non_flushes[rank]=i;
         }
     }
-    int findRank(const vector<int> & hand){
+    
+#if CHECKRANK_X86
+    // Rank the hands 8 at a time and return how many were ranked. The
+    // non-flush ranks are gathered from the tables; the rare lanes that
+    // hold a flush are ranked with the scalar lookup.
+    __attribute__((target("avx2")))
+    int lookup_ranks_avx2(const int * const cards[5], int n, int * ranks){
+        const __m256i low=_mm256_set1_epi32(255);
+        const __m256i suits=_mm256_set1_epi32(0xF00);
+        const __m256i low16=_mm256_set1_epi32(0xFFFF);
+        const __m256i bucket_multiplier=_mm256_set1_epi32(0x9E3779B1u);
+        const __m256i slot_multiplier=_mm256_set1_epi32(hash_multiplier);
+        int i=0;
+        for(;i+8<=n;i+=8){
+            __m256i c[5];
+            for(int k=0;k<5;++k)
+                c[k]=_mm256_loadu_si256((const __m256i *) (cards[k]+i));
+            __m256i suit=_mm256_and_si256(_mm256_and_si256(_mm256_and_si256(c[0],c[1]),_mm256_and_si256(c[2],c[3])),_mm256_and_si256(c[4],suits));
+            __m256i product=_mm256_and_si256(c[0],low);
+            for(int k=1;k<5;++k)
+                product=_mm256_mullo_epi32(product,_mm256_and_si256(c[k],low));
+            __m256i bucket=_mm256_srli_epi32(_mm256_mullo_epi32(product,bucket_multiplier),22);
+            __m256i slot=_mm256_srli_epi32(_mm256_mullo_epi32(product,slot_multiplier),19);
+            slot=_mm256_xor_si256(slot,_mm256_i32gather_epi32(displacement.data(),bucket,4));
+            __m256i rank=_mm256_and_si256(_mm256_i32gather_epi32((const int *) non_flush_ranks.data(),slot,2),low16);
+            _mm256_storeu_si256((__m256i *) (ranks+i),rank);
+            int flush=_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(suit,_mm256_setzero_si256())));
+            while(flush){
+                int j=i+__builtin_ctz(flush);
+                int hand[5]={cards[0][j],cards[1][j],cards[2][j],cards[3][j],cards[4][j]};
+                ranks[j]=lookup_rank(hand);
+                flush&=flush-1;
+            }
+        }
+        return i;
+    }
+#endif
+    
+    // Rank of a hand of any size from the hash maps.
+    int hash_rank(const int * hand, int n){
         int suit=hand[0];
         int rank=suit;
         suit=suit>>8;
         rank=rank&255; // 255=0b11111111
-        for(int i=1;i<hand.size();++i){
+        for(int i=1;i<n;++i){
             int s=hand[i];
             int r=s;
             s=s>>8;
@@ -87,10 +299,9 @@ public:
             suit=suit&s;
             rank=rank*r;
         }
-        if(suit>0)
-            return flushes[rank];
-        else
-            return non_flushes[rank];
+        const unordered_map<int,int> & ranks=suit>0 ? shared->flushes : shared->non_flushes;
+        auto it=ranks.find(rank);
+        return it!=ranks.end() ? it->second : 0;
     }
     // return rank from 0 (high card) to 8 (straight/royal flush)
     int bestRank(int r){
@@ -117,11 +328,45 @@ public:
         return 0;
     }
     string get_all_ranks(int n){
-        return all_ranks[n];
+        return shared->all_ranks[n];
     }
+    
+    void set_evaluator(Evaluator e){
+        evaluator=e;
+    }
+    
+    Evaluator get_evaluator(){
+        return evaluator;
+    }
+    
 private:
-    vector<string> all_ranks;
-    unordered_map<int,int> flushes;
-    unordered_map<int,int> non_flushes;
-    map<char,int> encode;
+    
+    static int bucket_of(unsigned product){
+        return (product*0x9E3779B1u)>>22;
+    }
+    
+    static int slot_of(unsigned product, unsigned multiplier){
+        return (product*multiplier)>>19;
+    }
+    
+    static bool cpu_has_avx2(){
+#if CHECKRANK_X86
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    
+    Evaluator evaluator;
+    bool use_avx2;
+    const Tables * shared; // ranks and hash maps of the hash_map evaluator
+    // Tables of the lookup_table evaluator, copied from the shared ones so
+    // that the lookups do not go through a pointer.
+    static constexpr array<int,42> rank_bit=RankCodes::rank_bit(); // bit of each card rank, by prime
+    array<unsigned short,8192> flush_ranks; // by mask of the card ranks
+    // by perfect hash slot, plus one entry of padding so that the 32-bit
+    // gathers of findRanks() stay inside the array
+    array<unsigned short,8193> non_flush_ranks;
+    array<int,1024> displacement; // by perfect hash bucket
+    unsigned hash_multiplier;
 };
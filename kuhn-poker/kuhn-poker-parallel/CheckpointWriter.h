@@ -0,0 +1,184 @@
+/********************************************************************************
+ 
+ Background writer of the outputs of a training run: the average strategies
+ (strategy_player.csv, strategy_dealer.csv), the bankroll time series
+ (player_fit_time_series.csv, dealer_fit_time_series.csv), the exploitability
+ time series, the printout of the average strategies, and the binary
+ checkpoint of the run.
+ 
+ The training thread hands over an immutable Snapshot with submit(), which
+ only moves it into a one-entry queue and returns: a snapshot that has not
+ been written yet is replaced by the newer one, so training never waits for
+ the disk or the terminal. A writer thread, started on the first submit(),
+ writes every file to a temporary file first and renames it over the old one,
+ so that a reader never sees a partial file. flush() waits until the last
+ snapshot is written. The CSV files go to the directory set with
+ set_directory(), the working directory by default.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class CheckpointWriter{
+    
+public:
+    
+    struct Snapshot{
+        Game::Table player_strategy;
+        Game::Table dealer_strategy;
+        vector<double> player_bankroll;
+        vector<double> dealer_bankroll;
+        vector<double> exploitability;
+        bool print=false;
+        string state_file; // binary checkpoint, written if "state" is not empty
+        vector<char> state;
+    };
+    
+    CheckpointWriter(){
+        pending=false;
+        busy=false;
+        stop=false;
+    }
+    
+    ~CheckpointWriter(){
+        {
+            lock_guard<mutex> lock(m);
+            stop=true;
+        }
+        ready.notify_all();
+        if(writer.joinable())
+            writer.join();
+    }
+    
+    CheckpointWriter(const CheckpointWriter &)=delete;
+    CheckpointWriter & operator=(const CheckpointWriter &)=delete;
+    
+    void submit(Snapshot s){
+        {
+            lock_guard<mutex> lock(m);
+            if(!writer.joinable())
+                writer=thread(&CheckpointWriter::run,this);
+            next=move(s);
+            pending=true;
+        }
+        ready.notify_all();
+    }
+    
+    // Set before the first submit().
+    void set_directory(const string & dir){
+        directory=dir;
+    }
+    
+    // "file" in the directory "dir" (the working directory if empty).
+    static string path(const string & dir, const string & file){
+        if(dir.empty())
+            return file;
+        char last=dir.back();
+        return last=='/'||last=='\\' ? dir+file : dir+"/"+file;
+    }
+    
+    // Time the writes as "phase" of the background row of "p".
+    void set_profiler(Profiler * p, int phase){
+        profiler=p;
+        profiler_phase=phase;
+    }
+    
+    // Wait until all submitted snapshots are written.
+    void flush(){
+        unique_lock<mutex> lock(m);
+        done.wait(lock,[this]{ return !pending&&!busy; });
+    }
+    
+private:
+    
+    void run(){
+        unique_lock<mutex> lock(m);
+        while(true){
+            ready.wait(lock,[this]{ return pending||stop; });
+            if(!pending)
+                return;
+            Snapshot s=move(next);
+            pending=false;
+            busy=true;
+            lock.unlock();
+            if(profiler){
+                Profiler::Timer timer(*profiler,Profiler::background,profiler_phase);
+                write(s);
+            }
+            else
+                write(s);
+            lock.lock();
+            busy=false;
+            done.notify_all();
+        }
+    }
+    
+    void write(const Snapshot & s){
+        if(s.print){
+            // print the whole grid at once, so that it is not interleaved
+            // with the output of the training thread
+            ostringstream os;
+            os << "Average betting strategy of Player is" << endl;
+            game.print_strategy(s.player_strategy,os);
+            os << "Average calling strategy of Dealer is" << endl;
+            game.print_strategy(s.dealer_strategy,os);
+            cout << os.str() << std::flush;
+        }
+        write_csv(path(directory,"strategy_player.csv"),s.player_strategy.data(),s.player_strategy.size());
+        write_csv(path(directory,"strategy_dealer.csv"),s.dealer_strategy.data(),s.dealer_strategy.size());
+        write_csv(path(directory,"player_fit_time_series.csv"),s.player_bankroll.data(),s.player_bankroll.size());
+        write_csv(path(directory,"dealer_fit_time_series.csv"),s.dealer_bankroll.data(),s.dealer_bankroll.size());
+        if(!s.exploitability.empty())
+            write_csv(path(directory,"exploitability_time_series.csv"),s.exploitability.data(),s.exploitability.size());
+        if(!s.state.empty())
+            write_binary(s.state_file,s.state);
+    }
+    
+    static void write_binary(const string & file, const vector<char> & bytes){
+        string tmp=file+".tmp";
+        ofstream os(tmp,ios::binary);
+        os.write(bytes.data(),bytes.size());
+        os.close();
+        replace(tmp,file,!os);
+    }
+    
+    // Move the temporary file "tmp" over "file", unless writing it failed.
+    static void replace(const string & tmp, const string & file, bool failed){
+        if(failed){
+            cout << "Could not write " << file << endl;
+            return;
+        }
+#ifdef _WIN32
+        remove(file.c_str());
+#endif
+        if(rename(tmp.c_str(),file.c_str())!=0)
+            cout << "Could not write " << file << endl;
+    }
+    
+    // Write the values on one comma-separated line, through a temporary file.
+    static void write_csv(const string & file, const double * values, int n){
+        if(n==0)
+            return;
+        string tmp=file+".tmp";
+        ofstream os(tmp);
+        for(int i=0;i<n-1;++i)
+            os << values[i] << ",";
+        os << values[n-1];
+        os.close();
+        replace(tmp,file,!os);
+    }
+    
+    Game game; // for print_strategy()
+    string directory;
+    Profiler * profiler=nullptr;
+    int profiler_phase=0;
+    mutex m;
+    condition_variable ready; // a snapshot is pending, or stop
+    condition_variable done; // the writer is idle
+    Snapshot next;
+    bool pending;
+    bool busy;
+    bool stop;
+    thread writer;
+    
+};
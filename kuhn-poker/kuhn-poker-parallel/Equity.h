@@ -0,0 +1,344 @@
+/********************************************************************************
+ 
+ Equities of all pairs of hole cards classes (the 169 strategy indexes of
+ Game), exact over all deals.
+ 
+ weight(i,j) is the probability that Player is dealt a hand of class i and
+ Dealer a hand of class j. win(i,j) and tie(i,j) are the probabilities that
+ Player wins or ties the showdown given these classes, over all 3-card boards.
+ 
+ The tables are built by enumerating every board. For each board the ranks
+ of all 2-card hands are computed once, and every hand of one representative
+ of each Player class is compared with every Dealer hand that does not share
+ a card with it. By suit symmetry all hands of a class give the same counts,
+ so the representative's counts are multiplied by the size of its class.
+ The boards are split between the OpenMP threads, each with its own counts,
+ which are added up at the end.
+ 
+ The tables can be saved to a binary file and loaded back without any
+ parsing. The file is a 64-byte header (magic "CFREQTY", format version,
+ number of classes, checksum of the data) followed by the weight, win and
+ tie tables as 169x169 doubles each. On POSIX systems the file is memory
+ mapped, so loading takes microseconds.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class Equity{
+    
+public:
+    
+    Equity(){
+        data.assign(3*169*169,0);
+        set_tables(data.data());
+        mapping=nullptr;
+        mapping_size=0;
+        built=false;
+    }
+    
+    ~Equity(){
+        unmap();
+    }
+    
+    // The tables may point into a memory mapping, which must not be shared.
+    Equity(const Equity &)=delete;
+    Equity & operator=(const Equity &)=delete;
+    
+    void build(CheckRank & checkrank){
+        Deck deck;
+        Game game;
+        vector<int> cards=deck.get_cards();
+        // all 1326 hands of two cards, with their class
+        vector<int> hand_card1, hand_card2, hand_class;
+        for(int a=0;a<52;++a)
+            for(int b=a+1;b<52;++b){
+                hand_card1.push_back(a);
+                hand_card2.push_back(b);
+                hand_class.push_back(game.strategy_index(cards[a],cards[b]));
+            }
+        // the first hand of each class is its representative
+        vector<int> representative(169,-1), class_size(169,0);
+        for(int h=0;h<1326;++h){
+            if(representative[hand_class[h]]<0)
+                representative[hand_class[h]]=h;
+            ++class_size[hand_class[h]];
+        }
+        vector<array<int,3>> boards;
+        for(int b1=0;b1<52;++b1)
+            for(int b2=b1+1;b2<52;++b2)
+                for(int b3=b2+1;b3<52;++b3)
+                    boards.push_back({b1,b2,b3});
+        int nboards=boards.size();
+        vector<long long> count(169*169,0), wins(169*169,0), ties(169*169,0);
+        #pragma omp parallel
+        {
+            vector<long long> thread_count(169*169,0), thread_wins(169*169,0), thread_ties(169*169,0);
+            vector<int> rank(1326);
+            int b;
+            #pragma omp for schedule(dynamic,64)
+            for(b=0;b<nboards;++b)
+                count_board(checkrank,cards,boards[b][0],boards[b][1],boards[b][2],hand_card1,hand_card2,
+                            hand_class,representative,rank,thread_count,thread_wins,thread_ties);
+            #pragma omp critical
+            for(int k=0;k<169*169;++k){
+                count[k]+=thread_count[k];
+                wins[k]+=thread_wins[k];
+                ties[k]+=thread_ties[k];
+            }
+        }
+        // number of (Player hand, Dealer hand, board) deals
+        double deals=1326.0*1225.0*17296.0;
+        unmap();
+        data.assign(3*169*169,0);
+        set_tables(data.data());
+        for(int i=0;i<169;++i)
+            for(int j=0;j<169;++j){
+                int k=169*i+j;
+                weight[k]=class_size[i]*count[k]/deals;
+                win[k]=count[k]>0 ? (double) wins[k]/count[k] : 0;
+                tie[k]=count[k]>0 ? (double) ties[k]/count[k] : 0;
+            }
+        built=true;
+    }
+    
+    // Write the tables to "file" (through a temporary file, so that a
+    // reader never sees a partial file).
+    bool save(const string & file){
+        Header header=make_header();
+        string tmp=file+".tmp";
+        ofstream os(tmp,ios::binary);
+        os.write((const char *) &header,sizeof(header));
+        os.write((const char *) weight,3*169*169*sizeof(double));
+        os.close();
+        if(!os||rename(tmp.c_str(),file.c_str())!=0){
+            cout << "Could not write the equities to " << file << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Load the tables saved by save(). Returns false, leaving the tables
+    // unchanged, if the file is missing or does not match this version.
+    bool load(const string & file){
+        size_t size=sizeof(Header)+3*169*169*sizeof(double);
+#ifndef _WIN32
+        int fd=open(file.c_str(),O_RDONLY);
+        if(fd<0)
+            return false;
+        struct stat st;
+        void * map=MAP_FAILED;
+        if(fstat(fd,&st)==0&&(size_t) st.st_size==size)
+            map=mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fd,0);
+        close(fd);
+        if(map==MAP_FAILED){
+            cout << "Equity file " << file << " has the wrong size" << endl;
+            return false;
+        }
+        const Header * header=(const Header *) map;
+        const double * tables=(const double *) ((const char *) map+sizeof(Header));
+        if(!check_header(*header,tables,file)){
+            munmap(map,size);
+            return false;
+        }
+        unmap();
+        mapping=map;
+        mapping_size=size;
+        data.clear();
+        set_tables(tables);
+#else
+        ifstream is(file,ios::binary);
+        if(!is)
+            return false;
+        Header header;
+        vector<double> tables(3*169*169);
+        is.read((char *) &header,sizeof(header));
+        is.read((char *) tables.data(),tables.size()*sizeof(double));
+        if(!is||!check_header(header,tables.data(),file))
+            return false;
+        data=tables;
+        set_tables(data.data());
+#endif
+        built=true;
+        return true;
+    }
+    
+    // Counts of the showdowns of the representatives against all Dealer
+    // hands on the board (b1,b2,b3).
+    void count_board(CheckRank & checkrank, const vector<int> & cards, int b1, int b2, int b3,
+                     const vector<int> & hand_card1, const vector<int> & hand_card2,
+                     const vector<int> & hand_class, const vector<int> & representative,
+                     vector<int> & rank, vector<long long> & count,
+                     vector<long long> & wins, vector<long long> & ties){
+        unsigned long long board=(1ULL<<b1)|(1ULL<<b2)|(1ULL<<b3);
+        // hands that do not share a card with the board
+        vector<int> hands, classes, c1, c2, c3, c4, c5;
+        vector<unsigned long long> masks;
+        for(int h=0;h<1326;++h){
+            unsigned long long mask=(1ULL<<hand_card1[h])|(1ULL<<hand_card2[h]);
+            if(board&mask)
+                continue;
+            hands.push_back(h);
+            classes.push_back(hand_class[h]);
+            masks.push_back(mask);
+            c1.push_back(cards[hand_card1[h]]);
+            c2.push_back(cards[hand_card2[h]]);
+            c3.push_back(cards[b1]);
+            c4.push_back(cards[b2]);
+            c5.push_back(cards[b3]);
+        }
+        int n=hands.size();
+        const int * hand_cards[5]={c1.data(),c2.data(),c3.data(),c4.data(),c5.data()};
+        vector<int> hand_rank(n);
+        checkrank.findRanks(hand_cards,n,hand_rank.data());
+        for(int k=0;k<n;++k)
+            rank[hands[k]]=hand_rank[k];
+        for(int i=0;i<169;++i){
+            int r=representative[i];
+            unsigned long long player=(1ULL<<hand_card1[r])|(1ULL<<hand_card2[r]);
+            if(board&player)
+                continue;
+            int player_rank=rank[r];
+            long long * row_count=&count[169*i];
+            long long * row_wins=&wins[169*i];
+            long long * row_ties=&ties[169*i];
+            for(int k=0;k<n;++k){
+                if(player&masks[k])
+                    continue;
+                int j=classes[k];
+                ++row_count[j];
+                row_wins[j]+=player_rank<hand_rank[k];
+                row_ties[j]+=player_rank==hand_rank[k];
+            }
+        }
+    }
+    
+    // Expected values of betting and of checking for each Player class,
+    // weighted by the probability of the deal, when Dealer calls with
+    // probabilities q.
+    void player_values(const Game::Table & q, double ante, double bet,
+                       Game::Table & bet_value, Game::Table & check_value){
+        for(int i=0;i<169;++i){
+            double vb=0, vc=0;
+            for(int j=0;j<169;++j){
+                int k=169*i+j;
+                double showdown=weight[k]*(2*win[k]+tie[k]-1); // weight*(win-loss)
+                vb+=weight[k]*(1-q[j])*ante+q[j]*(ante+bet)*showdown;
+                vc+=ante*showdown;
+            }
+            bet_value[i]=vb;
+            check_value[i]=vc;
+        }
+    }
+    
+    // Expected values of calling and of folding for each Dealer class,
+    // weighted by the probability of the deal and by the probability that
+    // Player bets, p.
+    void dealer_values(const Game::Table & p, double ante, double bet,
+                       Game::Table & call_value, Game::Table & fold_value){
+        for(int j=0;j<169;++j){
+            double vc=0, vf=0;
+            for(int i=0;i<169;++i){
+                int k=169*i+j;
+                double showdown=weight[k]*(2*win[k]+tie[k]-1);
+                vc-=p[i]*(ante+bet)*showdown;
+                vf-=p[i]*weight[k]*ante;
+            }
+            call_value[j]=vc;
+            fold_value[j]=vf;
+        }
+    }
+    
+    double get_weight(int i, int j){
+        return weight[169*i+j];
+    }
+    
+    double get_win(int i, int j){
+        return win[169*i+j];
+    }
+    
+    double get_tie(int i, int j){
+        return tie[169*i+j];
+    }
+    
+    bool is_built(){
+        return built;
+    }
+    
+private:
+    
+    struct Header{
+        char magic[8];
+        unsigned version;
+        unsigned classes;
+        unsigned long long checksum;
+        char padding[40];
+    };
+    
+    static const unsigned version=1;
+    
+    Header make_header(){
+        Header header;
+        memset(&header,0,sizeof(header));
+        memcpy(header.magic,"CFREQTY",8);
+        header.version=version;
+        header.classes=169;
+        header.checksum=checksum(weight);
+        return header;
+    }
+    
+    bool check_header(const Header & header, const double * tables, const string & file){
+        if(memcmp(header.magic,"CFREQTY",8)!=0||header.classes!=169){
+            cout << file << " is not an equity file" << endl;
+            return false;
+        }
+        if(header.version!=version){
+            cout << file << " has version " << header.version << ", expected " << version << endl;
+            return false;
+        }
+        if(header.checksum!=checksum(tables)){
+            cout << file << " is corrupted (wrong checksum)" << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Multiply-xor hash of the three tables, one 64-bit word at a time.
+    static unsigned long long checksum(const double * tables){
+        const unsigned char * bytes=(const unsigned char *) tables;
+        unsigned long long h=0x9E3779B97F4A7C15ULL;
+        for(size_t i=0;i<3*169*169;++i){
+            unsigned long long w;
+            memcpy(&w,bytes+8*i,8);
+            h=(h^w)*0x100000001B3ULL;
+            h^=h>>29;
+        }
+        return h;
+    }
+    
+    void set_tables(const double * tables){
+        weight=(double *) tables;
+        win=weight+169*169;
+        tie=win+169*169;
+    }
+    
+    void unmap(){
+#ifndef _WIN32
+        if(mapping!=nullptr)
+            munmap(mapping,mapping_size);
+#endif
+        mapping=nullptr;
+        mapping_size=0;
+    }
+    
+    // weight, win and tie, one after the other, either in "data" or in
+    // a read-only memory mapping of an equity file
+    vector<double> data;
+    double * weight;
+    double * win;
+    double * tie;
+    void * mapping;
+    size_t mapping_size;
+    bool built;
+    
+};
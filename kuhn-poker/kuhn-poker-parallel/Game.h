@@ -11,79 +11,104 @@
  
  This class uses prime-number representation of each poker rank.
  
- Player's and Dealer's regrets sums and strategy sums are vectors
- of size 2, of the structure (act, do not act). For the Player it
- is interpreted as (bet, do not bet), and for the Dealer it is
- interpreted as (call, do not call).
+ Player's and Dealer's regrets sums and strategy sums have two
+ entries per hand, of the structure (act, do not act). For the Player
+ it is interpreted as (bet, do not bet), and for the Dealer it is
+ interpreted as (call, do not call). They are stored as one flat,
+ cache-line aligned array per action, and are read and updated in
+ place, so that the training loop never allocates.
+ 
+ The strategy index of a pair of hole cards is read from tables that are
+ computed at compile time: every card is mapped to a number 0...51 by its
+ suit bits and prime, and every pair of card numbers to its index 0...168.
  
  ********************************************************************/
 
 using namespace std;
 
+// Compile-time tables of Game::strategy_index().
+struct HandIndex{
+    
+    // Key of a card in card_id: suit bits (1, 2, 4 or 8) and prime.
+    static constexpr int card_key(int card){
+        return ((card>>8)<<6)|(card&63);
+    }
+    
+    // Number 13*suit+rank of each card, by card_key.
+    static constexpr array<unsigned char,576> card_id(){
+        array<unsigned char,576> id={};
+        const int primes[13]={2,3,5,7,11,13,17,19,23,29,31,37,41};
+        for(int suit=0;suit<4;++suit)
+            for(int i=0;i<13;++i)
+                id[card_key(((1<<suit)<<8)|primes[i])]=13*suit+i;
+        return id;
+    }
+    
+    // Strategy index of each pair of card numbers, 52*id1+id2: pairs on
+    // the diagonal, suited hands above it and offsuit hands below it.
+    static constexpr array<unsigned char,52*52> hand_index(){
+        array<unsigned char,52*52> index={};
+        for(int a=0;a<52;++a)
+            for(int b=0;b<52;++b){
+                int r1=a%13, r2=b%13;
+                bool same_suit=a/13==b/13;
+                int i=0, j=0;
+                if(r1==r2||same_suit){
+                    i=min(r1,r2);
+                    j=max(r1,r2);
+                }
+                else{
+                    i=max(r1,r2);
+                    j=min(r1,r2);
+                }
+                index[52*a+b]=13*i+j;
+            }
+        return index;
+    }
+    
+};
+
 class Game{
     
 public:
     
+    // One entry per pair of hole cards.
+    typedef array<double,169> Table;
+    
+    // Table which starts on its own cache line.
+    struct alignas(64) AlignedTable : public Table {};
+    
     Game(){
-        for(int i=0;i<169;++i){
-            strategy.push_back(0.5);
-            average_strategy.push_back(0);
-            vector<double> r={0,0};
-            regret_sum.push_back(r);
-            strategy_sum.push_back(r);
+        strategy.fill(0.5);
+        average_strategy.fill(0);
+        for(int a=0;a<2;++a){
+            regret_sum[a].fill(0);
+            strategy_sum[a].fill(0);
         }
         bankroll=0;
         subconstructor();
     }
     
     void subconstructor(){
-        prime_to_index={{2,0},{3,1},{5,2},{7,3},{11,4},{13,5},
-            {17,6},{19,7},{23,8},{29,9},{31,10},{37,11},{41,12}};
         index_to_rank={"A","K","Q","J","10","9","8","7","6","5","4","3","2"};
     }
     
     int strategy_index(const vector<int> & hole_cards){
+        return strategy_index(hole_cards[0],hole_cards[1]);
+    }
+    
+    static int strategy_index(int card1, int card2){
     // returns index 0...168 corresponding to pair of hole cards.
-        int card1=hole_cards[0];
-        int card2=hole_cards[1];
-        int s1=card1>>8;
-        int s2=card2>>8;
-        bool same_suit=false;
-        if(s1==s2)
-            same_suit=true;
-        int r1=prime_to_index[card1&255];
-        int r2=prime_to_index[card2&255];
-        int i,j;
-        if(r1==r2){
-            i=r1;
-            j=r1;
-        }
-        else if(same_suit){
-            if(r1<r2){
-                i=r1;
-                j=r2;
-            }
-            else{
-                i=r2;
-                j=r1;
-            }
-        }
-        else{
-            if(r1<r2){
-                i=r2;
-                j=r1;
-            }
-            else{
-                i=r1;
-                j=r2;
-            }
-        }
-        return 13*i+j;
+        int id1=card_id[HandIndex::card_key(card1)];
+        int id2=card_id[HandIndex::card_key(card2)];
+        return hand_index[52*id1+id2];
     }
     
-    bool act(const vector<int> & hole_cards){
-        double p=strategy[strategy_index(hole_cards)];
-        double r=((double) rand() /RAND_MAX);
+    // Draws whether to act with the hand of strategy index k, from the
+    // given generator, so it can be called from several threads.
+    bool act(const int & k, Rng & rng){
+        double p=strategy[k];
+        double r=rng.uniform();
         if(r<p)
             return true; // act (bet or call)
         else
@@ -98,12 +123,32 @@ public:
         average_strategy[k]=p;
     }
     
-    void set_strategy_sum(const int & k, const vector<double> & p){
-        strategy_sum[k]=p;
+    // Regret and strategy sums of hand k for action a, where a=0 is
+    // "act" and a=1 is "do not act".
+    void set_strategy_sum(const int & k, const double & s0, const double & s1){
+        strategy_sum[0][k]=s0;
+        strategy_sum[1][k]=s1;
+    }
+    
+    void set_regret_sum(const int & k, const double & r0, const double & r1){
+        regret_sum[0][k]=r0;
+        regret_sum[1][k]=r1;
+    }
+    
+    void add_strategy_sum(const int & k, const double & s0, const double & s1){
+        strategy_sum[0][k]+=s0;
+        strategy_sum[1][k]+=s1;
     }
     
-    void set_regret_sum(const int & k, const vector<double> & p){
-        regret_sum[k]=p;
+    void add_regret_sum(const int & k, const double & r0, const double & r1){
+        regret_sum[0][k]+=r0;
+        regret_sum[1][k]+=r1;
+    }
+    
+    // Set the negative regrets of hand k to zero (CFR+).
+    void floor_regret_sum(const int & k){
+        regret_sum[0][k]=max(regret_sum[0][k],0.0);
+        regret_sum[1][k]=max(regret_sum[1][k],0.0);
     }
     
     double get_strategy(const int & k){
@@ -114,28 +159,28 @@ public:
         return average_strategy[k];
     }
     
-    vector<double> get_strategy_sum(const int & k){
-        return strategy_sum[k];
+    double get_strategy_sum(const int & k, const int & a){
+        return strategy_sum[a][k];
     }
     
-    vector<double> get_regret_sum(const int & k){
-        return regret_sum[k];
+    double get_regret_sum(const int & k, const int & a){
+        return regret_sum[a][k];
     }
     
-    vector<double> get_whole_strategy(){
+    const Table & get_whole_strategy(){
         return strategy;
     }
     
-    vector<double> get_whole_average_strategy(){
+    const Table & get_whole_average_strategy(){
         return average_strategy;
     }
     
-    vector<vector<double>> get_whole_strategy_sum(){
-        return strategy_sum;
+    const Table & get_whole_strategy_sum(const int & a){
+        return strategy_sum[a];
     }
     
-    vector<vector<double>> get_whole_regret_sum(){
-        return regret_sum;
+    const Table & get_whole_regret_sum(const int & a){
+        return regret_sum[a];
     }
     
     void change_bankroll(const double & b){
@@ -150,22 +195,18 @@ public:
         return bankroll;
     }
     
-    void print_strategy(const vector<double> & v){
-        if(v.size()!=169){
-            cout << "Wrong sized-strategy sent to print" << endl;
-            throw "Wrong sized-strategy sent to print";
-        }
-        cout << "Strategy has length " << v.size() << ", and is de-serialzied as" << endl;
-        cout << "        ";
+    void print_strategy(const Table & v, ostream & os=cout){
+        os << "Strategy has length " << v.size() << ", and is de-serialzied as" << endl;
+        os << "        ";
         for(string s : index_to_rank){
-            cout << s << "          ";
+            os << s << "          ";
         }
-        cout << endl;
+        os << endl;
         for(int i=0;i<13;++i){
             if(i!=4)
-                cout << index_to_rank[i] << "       ";
+                os << index_to_rank[i] << "       ";
             else // leave a smaller margin for rank 10
-                cout << index_to_rank[i] << "      ";
+                os << index_to_rank[i] << "      ";
             for(int j=0;j<13;++j){
                 ostringstream strs;
                 double e=v[13*i+j];
@@ -182,20 +223,21 @@ public:
                 else
                     for(int k=0;k<12-str.size();++k)
                         buffer+=" ";
-                cout << str << buffer;
+                os << str << buffer;
             }
-            cout << endl;
+            os << endl;
         }
     }
     
 private:
     
     double bankroll;
-    vector<double> strategy;
-    vector<double> average_strategy;
-    vector<vector<double>> strategy_sum;
-    vector<vector<double>> regret_sum;
-    unordered_map<int,int> prime_to_index;
+    AlignedTable strategy;
+    AlignedTable average_strategy;
+    AlignedTable strategy_sum[2];
+    AlignedTable regret_sum[2];
     vector<string> index_to_rank;
+    static constexpr array<unsigned char,576> card_id=HandIndex::card_id();
+    static constexpr array<unsigned char,52*52> hand_index=HandIndex::hand_index();
     
 };
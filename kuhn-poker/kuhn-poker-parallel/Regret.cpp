@@ -1,16 +1,13 @@
 /********************************************************************************
  
- Two players are in a heads-up game. Each player is dealt two private cards.
- One player (Dealer) is on the button. The other (Player) bets/checks. Dealer
- calls/folds, then three community cards are dealt and the showdown occurs.
- To enter the round both Player and Dealer put the same ante. The bet size is
- fixed.
+ Command line trainer: reads the settings of a run from flags and from a
+ config file (Config.h), optimizes the strategies of Player and Dealer with
+ the Regret class of Regret.h, and writes a JSON summary of the run and
+ the time of every phase by thread (profile.csv).
+ 
+ Example: kuhn_parallel --threads 4 --rounds 100000 --batches 20 --output-dir run1
+ Run with --help for the list of settings.
  
- Optimize the strategies using the counterfactual regret minimization algorithm.
- Optimization is done in batches so that one can keep track of the performance
- of the players as the optimization progresses.
-
-Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
  ********************************************************************************/
 
 #include <iostream>
@@ -27,344 +24,213 @@ Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
 #include <fstream>
 #include <unordered_map>
 #include <stdexcept>
+#include <filesystem>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <cmath>
+#include <cerrno>
+#include <climits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <omp.h>
+#include "Rng.h"
 #include "Deck.h"
+#include "RankTable.h"
 #include "CheckRank.h"
 #include "Game.h"
+#include "AtomicGame.h"
+#include "Equity.h"
+#include "BestResponse.h"
+#include "Profiler.h"
+#include "CheckpointWriter.h"
+#include "Regret.h"
+#include "Config.h"
 
 using namespace std;
 
-class Regret{
-    
-public:
-    
-    Regret(double bank, int R, double Bet, double Ante, int E){
-        start_bankroll=bank;
-        Rounds=R;
-        bet=Bet;
-        ante=Ante;
-        Optimization_rounds=E;
-        Player.set_bankroll(start_bankroll);
-        Dealer.set_bankroll(start_bankroll);
-    }
-    
-    // This function is called after each round of poker in order to update
-    // regrets and strategies counts. If at the given round of poker (played
-    // by the poker() method) the player was dealt hand "ip" and the dealer
-    // was dealt hand "id", then we need to update strategies of player
-    // and dealer when holding hands "ip" and "id", repsectively.
-    void prepare_strategies(int ip, int id){
-        vector<double> player_regrets=Player.get_regret_sum(ip);
-        vector<double> dealer_regrets=Dealer.get_regret_sum(id);
-        double pR0=player_regrets[0];
-        double pR1=player_regrets[1];
-        double dR0=dealer_regrets[0];
-        double dR1=dealer_regrets[1];
-        if(pR0<0)
-            pR0=0;
-        if(pR1<0)
-            pR1=0;
-        if(dR0<0)
-            dR0=0;
-        if(dR1<0)
-            dR1=0;
-        double player_regrets_tot=pR0+pR1;
-        double dealer_regrets_tot=dR0+dR1;
-        // Set Player's strategy
-        if(player_regrets_tot<=0)
-            Player.set_strategy(ip,0.5);
-        else{
-            double R=pR0/player_regrets_tot;
-            Player.set_strategy(ip,R);
-        }
-        // Set Dealer's strategy
-        if(dealer_regrets_tot<=0)
-            Dealer.set_strategy(id,0.5);
-        else{
-            double R=dR0/dealer_regrets_tot;
-            Dealer.set_strategy(id,R);
-        }
-        // Add strategies to strategies sums
-        // Player.
-        vector<double> player_strat_sum=Player.get_strategy_sum(ip);
-        double p=Player.get_strategy(ip);
-        double p_tilde=1-p;
-        player_strat_sum[0]+=p;
-        player_strat_sum[1]+=p_tilde;
-        Player.set_strategy_sum(ip,player_strat_sum);
-        // Dealer.
-        vector<double> dealer_strat_sum=Dealer.get_strategy_sum(id);
-        double q=Dealer.get_strategy(id);
-        double q_tilde=1-q;
-        dealer_strat_sum[0]+=q;
-        dealer_strat_sum[1]+=q_tilde;
-        Dealer.set_strategy_sum(id,dealer_strat_sum);
-    }
-    
-    void calculate_average_strategy(){
-        int j;
-        #pragma omp parallel for private(j)
-        for(j=0;j<169;++j){
-            vector<double> player_strat_sum=Player.get_strategy_sum(j);
-            Player.set_average_strategy(j,player_strat_sum[0]/(player_strat_sum[0]+player_strat_sum[1]));
-            vector<double> dealer_strat_sum=Dealer.get_strategy_sum(j);
-            Dealer.set_average_strategy(j,dealer_strat_sum[0]/(dealer_strat_sum[0]+dealer_strat_sum[1]));
-        }
-    }
-    
-    vector<int> poker(){
-        // Both player and dealer put the same ante
-        // Deal the hole cards to player and dealer
-        Deck deck;
-        int c1=deck.deal_card();
-        int c2=deck.deal_card();
-        int c3=deck.deal_card();
-        int c4=deck.deal_card();
-        vector<int> player_hand={c1,c2};
-        vector<int> dealer_hand={c3,c4};
-        // strategy indexes of Player and Dealer
-        int player_strategy_index=Player.strategy_index(player_hand);
-        int dealer_strategy_index=Dealer.strategy_index(dealer_hand);
-        // current regrets of Player and Dealer
-        vector<double> player_regret=Player.get_regret_sum(player_strategy_index);
-        vector<double> dealer_regret=Dealer.get_regret_sum(dealer_strategy_index);
-        // Deal the community cards
-        for(int i=0;i<3;++i){
-            int c=deck.deal_card();
-            player_hand.push_back(c);
-            dealer_hand.push_back(c);
-        }
-        // Compare the ranks of the best hands player and dealer can claim
-        int player_rank=checkrank.findRank(player_hand);
-        int dealer_rank=checkrank.findRank(dealer_hand);
-        // Determine who wins
-        bool player_wins=player_rank<dealer_rank ? true : false;
-        double p=Player.get_strategy(player_strategy_index); // probability for Player to bet
-        double q=Dealer.get_strategy(dealer_strategy_index); // probability for Dealer to call
-        // Consider various game states, defined by who wins or whether it's a draw.
-        if(player_rank==dealer_rank){
-            // Expected value of Player's strategy given the current game state.
-            double Vp=p*(1-q)*ante;
-            vector<double> pr={player_regret[0]+(1-q)*ante-Vp,player_regret[1]-Vp};
-            Player.set_regret_sum(player_strategy_index,pr);
-            // Expected value of Dealer's strategy given the current game state.
-            double Vd=(1-q)*(-ante);
-            vector<double> dr={dealer_regret[0]+p*(-Vd),dealer_regret[1]+p*(-ante-Vd)};
-            Dealer.set_regret_sum(dealer_strategy_index,dr);
-        }
-        else if(player_wins){
-            // Expected value of Player's strategy given the current game state.
-            double Vp=(1-p)*ante+p*((1-q)*ante+q*(ante+bet));
-            vector<double> pr={player_regret[0]+(1-q)*ante+q*(ante+bet)-Vp,player_regret[1]+ante-Vp};
-            Player.set_regret_sum(player_strategy_index,pr);
-            // Expected value of Dealer's strategy given the current game state.
-            double Vd=(1-q)*(-ante)+q*(-ante-bet);
-            vector<double> dr={dealer_regret[0]+p*(-ante-bet-Vd),dealer_regret[1]+p*(-ante-Vd)};
-            Dealer.set_regret_sum(dealer_strategy_index,dr);
-        }
-        else if(!player_wins){
-            // Expected value of Player's strategy given the current game state.
-            double Vp=(1-p)*(-ante)+p*((1-q)*ante+q*(-ante-bet));
-            vector<double> pr={player_regret[0]+(1-q)*ante+q*(-ante-bet)-Vp,player_regret[1]-ante-Vp};
-            Player.set_regret_sum(player_strategy_index,pr);
-            // Expected value of Dealer's strategy given the current game state.
-            double Vd=(1-q)*(-ante)+q*(ante+bet);
-            vector<double> dr={dealer_regret[0]+p*(ante+bet-Vd),dealer_regret[1]+p*(-ante-Vd)};
-            Dealer.set_regret_sum(dealer_strategy_index,dr);
-        }
-        vector<int> ret={player_strategy_index,dealer_strategy_index};
-        // Before returning, play the actual game.
-        double is_bet=Player.act(player_hand); // If Player bets
-        double is_call=Dealer.act(dealer_hand); // If Dealer calls
-        if(is_bet){
-            if(is_call){
-                if(player_rank==dealer_rank)
-                    return ret;
-                else if(player_wins){
-                    Player.change_bankroll(bet+ante);
-                    Dealer.change_bankroll(-bet-ante);
-                    return ret;
-                }
-                else if(!player_wins){
-                    Dealer.change_bankroll(bet+ante);
-                    Player.change_bankroll(-bet-ante);
-                    return ret;
-                }
-            }
-            else{
-                Player.change_bankroll(ante);
-                Dealer.change_bankroll(-ante);
-                return ret;
-            }
-        }
-        else{
-            if(player_rank==dealer_rank)
-                return ret;
-            else if(player_wins){
-                Player.change_bankroll(ante);
-                Dealer.change_bankroll(-ante);
-                return ret;
-            }
-            else if(!player_wins){
-                Dealer.change_bankroll(ante);
-                Player.change_bankroll(-ante);
-                return ret;
-            }
-        }
-        return ret;
-    }
-
-    void play(){
-        Player.set_bankroll(start_bankroll);
-        Dealer.set_bankroll(start_bankroll);
-        vector<int> players; int i;
-        for(i=0;i<Rounds;++i){
-            players=poker();
-            prepare_strategies(players[0],players[1]);
-        }
-        double p=Player.get_bankroll()/start_bankroll;
-        double d=Dealer.get_bankroll()/start_bankroll;
-        cout << "Player's return is " << p << ", Dealer's return is " << d << endl;
-        player_bankroll.push_back(p);
-        dealer_bankroll.push_back(d);
-    }
+const char * mode_names[]={"sampled","exact"};
+const char * rule_names[]={"vanilla","cfr+","discounted"};
+const char * parallelism_names[]={"sharded","hogwild"};
+
+// Index of "value" in "names", or -1 after printing the valid values.
+int find_name(const string & setting, const string & value, const char * const * names, int n){
+    for(int i=0;i<n;++i)
+        if(value==names[i])
+            return i;
+    cout << "Invalid value \"" << value << "\" for " << setting << ", expected one of";
+    for(int i=0;i<n;++i)
+        cout << " " << names[i];
+    cout << endl;
+    return -1;
+}
 
-    void optimize(){
-        int i;
-        #pragma omp parallel for private(i)
-        for(i=0;i<Optimization_rounds;++i){
-            cout << "i=" << i << endl;
-            play();
-            if(i%10==0){
-                calculate_average_strategy();
-                print_average_strategy();
-                save_average_strategy();
-                save_time_series();
-            }
-        }
-        calculate_average_strategy();
-        print_average_strategy();
-        save_average_strategy();
-        save_time_series();
-    }
+void write_json_series_end(ostream & os, const vector<double> & v){
+    if(v.empty())
+        os << "null";
+    else
+        os << v.back();
+}
 
-    void print_average_strategy(){
-        cout << "Average betting strategy of Player is" << endl;
-        Player.print_strategy(Player.get_whole_average_strategy());
-        cout << "Average calling strategy of Dealer is" << endl;
-        Dealer.print_strategy(Dealer.get_whole_average_strategy());
-    }
-    
-    void save_average_strategy(){
-        // Save Player's strategy
-        vector<double> player_strategy=Player.get_whole_average_strategy();
-        ofstream file_player;
-        file_player.open("strategy_player.csv");
-        int n;
-        #pragma omp parallel for private(n)
-        for(n=0; n<168; n++){
-            file_player << player_strategy[n];
-            file_player << "," ;
-        }
-        file_player << player_strategy[168];
-        file_player.close();
-        // Save Dealer's strategy
-        vector<double> dealer_strategy=Dealer.get_whole_average_strategy();
-        ofstream file_dealer;
-        file_dealer.open("strategy_dealer.csv");
-        #pragma omp parallel for private(n)
-        for(n=0; n<168; n++){
-            file_dealer << dealer_strategy[n];
-            file_dealer << "," ;
-        }
-        file_dealer << dealer_strategy[168];
-        file_dealer.close();
+// Machine-readable summary of a run: settings, timing and final results.
+bool write_summary(const string & file, Regret & regret, int threads, int first_batch, double wall_seconds, double cpu_seconds){
+    ofstream os(file);
+    int batches=regret.get_batch()-first_batch;
+    bool sampled=regret.get_mode()==Regret::Mode::sampled;
+    os.precision(10);
+    os << "{" << endl;
+    os << "  \"program\": \"kuhn_parallel\"," << endl;
+    os << "  \"seed\": " << regret.get_seed() << "," << endl;
+    os << "  \"threads\": " << threads << "," << endl;
+    os << "  \"mode\": \"" << mode_names[(int) regret.get_mode()] << "\"," << endl;
+    os << "  \"rule\": \"" << rule_names[(int) regret.get_update_rule()] << "\"," << endl;
+    os << "  \"parallelism\": \"" << parallelism_names[(int) regret.get_parallelism()] << "\"," << endl;
+    os << "  \"rounds_per_batch\": " << regret.get_rounds() << "," << endl;
+    os << "  \"first_batch\": " << first_batch << "," << endl;
+    os << "  \"batches\": " << batches << "," << endl;
+    os << "  \"wall_seconds\": " << wall_seconds << "," << endl;
+    os << "  \"cpu_seconds\": " << cpu_seconds << "," << endl;
+    os << "  \"batches_per_second\": " << (wall_seconds>0 ? batches/wall_seconds : 0) << "," << endl;
+    os << "  \"rounds_per_second\": ";
+    if(sampled)
+        os << (wall_seconds>0 ? (double) batches*regret.get_rounds()/wall_seconds : 0);
+    else
+        os << "null";
+    os << "," << endl;
+    // rounds per second of every thread in the last sampled batch
+    os << "  \"thread_rounds_per_second\": [";
+    const vector<Regret::ThreadStats> & stats=regret.get_thread_stats();
+    for(size_t t=0;sampled&&t<stats.size();++t)
+        os << (t>0 ? ", " : "") << (stats[t].seconds>0 ? stats[t].rounds/stats[t].seconds : 0);
+    os << "]," << endl;
+    os << "  \"player_return\": ";
+    write_json_series_end(os,regret.get_player_bankroll());
+    os << "," << endl;
+    os << "  \"dealer_return\": ";
+    write_json_series_end(os,regret.get_dealer_bankroll());
+    os << "," << endl;
+    os << "  \"exploitability\": ";
+    write_json_series_end(os,regret.get_exploitability_series());
+    os << "," << endl;
+    os << "  \"profile\": ";
+    regret.get_profiler().write_json(os,"  ");
+    os << endl << "}" << endl;
+    os.close();
+    if(!os){
+        cout << "Could not write " << file << endl;
+        return false;
     }
-    
-    void save_time_series(){
-        // Save Player's fit time series
-        ofstream file_player;
-        file_player.open("player_fit_time_series.csv");
-        int vsize = player_bankroll.size()-1; int n;
-        #pragma omp parallel for private(n)
-            for(n=0; n<vsize; n++){
-                file_player << player_bankroll[n];
-                file_player << "," ;
-        }
-        
-        file_player << player_bankroll[vsize];
-        file_player.close();
-        // Save Dealer's fit time series
-        ofstream file_dealer;
-        file_dealer.open("dealer_fit_time_series.csv");
-        vsize = dealer_bankroll.size()-1;
-        #pragma omp parallel for private(n)
-        for(int n=0; n<vsize; n++){
-            file_dealer << dealer_bankroll[n];
-            file_dealer << "," ;
-        }
-        file_dealer << dealer_bankroll[vsize];
-        file_dealer.close();
-    }
-
-private:
-    
-    double start_bankroll;
-    double Rounds;
-    double bet;
-    double ante;
-    int Optimization_rounds;
-
-    Game Player;
-    Game Dealer;
-
-    CheckRank checkrank;
-
-    vector<double> player_bankroll;
-    vector<double> dealer_bankroll;
-    
-};
-
-int main(){
-    
-    srand(10000*time(0));
+    return true;
+}
 
-    int thread_count= 4;
-    cout<<"Enter number of threads: \n";
-    cin>>thread_count;
+int main(int argc, char ** argv){
     
-    omp_set_num_threads(thread_count);
-
-    //bankroll reset at the beginning of each batch of self-training
-    //double start_bankroll=1000000.0;
-    double start_bankroll=10000.0;
-
+    Config config;
+    config.add("threads",Config::Kind::integer,to_string(omp_get_max_threads()),"number of OpenMP threads");
+    config.set_range("threads",1,INT_MAX);
     //number of play rounds in a batch used to evaluate performance
-    //int game_rounds=1000000;
-    int game_rounds=100000;
-    cout<<"Enter game rounds: (Eg: 100000)\n";
-    cin>>game_rounds;
-    
-    //bet size
-    double bet=2;
+    config.add("rounds",Config::Kind::integer,"100000","game rounds per batch");
+    config.set_range("rounds",0,INT_MAX);
+    //number of batches of CFR optimization
+    config.add("batches",Config::Kind::integer,"20","optimization rounds (batches)");
+    config.set_range("batches",0,INT_MAX);
+    config.add("seed",Config::Kind::integer,"","seed of the run (default: the time)");
+    //bankroll reset at the beginning of each batch of self-training
+    config.add("bankroll",Config::Kind::real,"10000","bankroll at the start of a batch");
+    config.add("bet",Config::Kind::real,"2","bet size");
     //each player places the same ante before the game
-    double ante=1;
+    config.add("ante",Config::Kind::real,"1","ante of each player");
+    config.add("mode",Config::Kind::text,"sampled","training mode: sampled or exact");
+    config.add("rule",Config::Kind::text,"vanilla","update rule: vanilla, cfr+ or discounted");
+    config.add("alpha",Config::Kind::real,"1.5","discount of positive regrets (discounted)");
+    config.add("beta",Config::Kind::real,"0","discount of negative regrets (discounted)");
+    config.add("gamma",Config::Kind::real,"2","discount of the average strategy (discounted)");
+    config.add("parallel",Config::Kind::text,"sharded","parallel mode of sampled rounds: sharded or hogwild");
+    config.add("check-every",Config::Kind::integer,"0","exploitability check interval in batches (0 = never)");
+    config.set_range("check-every",0,INT_MAX);
+    config.add("target",Config::Kind::real,"0","stop when the exploitability is at most this");
+    config.add("output-dir",Config::Kind::text,".","directory of the CSV files, checkpoint and summary");
+    config.add("checkpoint-every",Config::Kind::integer,"10","checkpoint interval in batches (0 = only at the end)");
+    config.set_range("checkpoint-every",0,INT_MAX);
+    config.add("equity-file",Config::Kind::text,"equity.bin","cache of the equity table (exact mode)");
+    config.add("resume",Config::Kind::text,"","continue the run saved in this checkpoint");
+    config.add("summary",Config::Kind::text,"","JSON summary file (default: summary.json in the output directory)");
+    if(!config.parse(argc,argv))
+        return 1;
+    
+    int mode=find_name("mode",config.get_string("mode"),mode_names,2);
+    int rule=find_name("rule",config.get_string("rule"),rule_names,3);
+    int parallelism=find_name("parallel",config.get_string("parallel"),parallelism_names,2);
+    int thread_count=config.get_int("threads");
+    if(mode<0||rule<0||parallelism<0)
+        return 1;
+    
+    // seed of the training run; the same seed and number of threads
+    // reproduce the same strategies
+    unsigned long long seed=config.has("seed") ? config.get_int("seed") : time(0);
     
-    //number of batches of CFR optimization
-    //int optimization_rounds=2000;
-    int optimization_rounds=20;
-    cout<<"Enter optimisation rounds (epoc, Eg: 20)\n";
-    cin>>optimization_rounds;
-
-    clock_t time_req; time_req = clock();
+    omp_set_num_threads(thread_count);
     
-    Regret regret(start_bankroll,game_rounds,bet,ante,optimization_rounds);
+    string output_dir=config.get_string("output-dir");
+    error_code error;
+    filesystem::create_directories(output_dir,error);
+    if(error){
+        cout << "Cannot create " << output_dir << ": " << error.message() << endl;
+        return 1;
+    }
+    string summary_file=config.has("summary") ? config.get_string("summary") : CheckpointWriter::path(output_dir,"summary.json");
+    
+    Regret regret(config.get_double("bankroll"),config.get_int("rounds"),config.get_double("bet"),config.get_double("ante"),config.get_int("batches"),seed);
+    regret.set_mode((Regret::Mode) mode);
+    regret.set_update_rule((Regret::UpdateRule) rule,config.get_double("alpha"),config.get_double("beta"),config.get_double("gamma"));
+    regret.set_parallelism((Regret::Parallelism) parallelism);
+    regret.set_exploitability_check(config.get_int("check-every"),config.get_double("target"));
+    regret.set_output_dir(output_dir);
+    regret.set_checkpoint_every(config.get_int("checkpoint-every"));
+    regret.set_equity_file(config.get_string("equity-file"));
+    // the settings of the run and its seed are taken from the checkpoint
+    string resume_file=config.get_string("resume");
+    if(!resume_file.empty()){
+        if(!regret.load_state(resume_file))
+            return 1;
+        cout<<"Resumed from "<<resume_file<<" at batch "<<regret.get_batch()<<endl;
+    }
+    cout<<"Seed: "<<regret.get_seed()<<endl;
+    int first_batch=regret.get_batch();
+    
+    // clock() adds up the CPU time of all threads: the wall time is what a
+    // parallel run saves
+    clock_t cpu_start=clock();
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
     
     regret.optimize();
-
-    time_req = clock() - time_req;
-
-    cout<<"\nProgram Execution Time: "<<time_req*1000/CLOCKS_PER_SEC<<" ms"<<endl;
+    
+    double wall_seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    double cpu_seconds=(double) (clock()-cpu_start)/CLOCKS_PER_SEC;
+    
+    cout<<"\nProgram Execution Time: "<<wall_seconds*1000<<" ms (CPU time "<<cpu_seconds*1000<<" ms)"<<endl;
+    Profiler & profiler=regret.get_profiler();
+    cout<<"Time by phase, summed over threads:"<<endl;
+    for(int p=0;p<profiler.phases();++p)
+        cout<<"  "<<profiler.name(p)<<": "<<profiler.seconds(p)*1000<<" ms"<<endl;
+    
+    if(!write_summary(summary_file,regret,thread_count,first_batch,wall_seconds,cpu_seconds))
+        return 1;
+    cout<<"Summary written to "<<summary_file<<endl;
+    string profile_file=CheckpointWriter::path(output_dir,"profile.csv");
+    if(!profiler.write_csv(profile_file)){
+        cout<<"Could not write "<<profile_file<<endl;
+        return 1;
+    }
     
     return 0;
 }
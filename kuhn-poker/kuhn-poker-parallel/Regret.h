@@ -0,0 +1,870 @@
+/********************************************************************************
+ 
+ Two players are in a heads-up game. Each player is dealt two private cards.
+ One player (Dealer) is on the button. The other (Player) bets/checks. Dealer
+ calls/folds, then three community cards are dealt and the showdown occurs.
+ To enter the round both Player and Dealer put the same ante. The bet size is
+ fixed.
+ 
+ Optimize the strategies using the counterfactual regret minimization algorithm.
+ Optimization is done in batches so that one can keep track of the performance
+ of the players as the optimization progresses.
+ 
+ In the exact mode, each batch is one iteration of vanilla CFR: instead of
+ sampling a deal, the regrets of every hand of both Player and Dealer are
+ updated with their exact expected values over all deals, computed from the
+ 169x169 table of equities of Equity.h. The table is computed on the first run
+ and cached in equity.bin.
+ 
+ The rounds of each batch are split between the OpenMP threads. Every thread
+ plays on a private shard of the Player/Dealer tables and the shards are merged
+ in a fixed order at the end of the batch, so that a run is reproducible for a
+ given seed and number of threads. In the hogwild mode the threads instead
+ update the same tables concurrently with atomic additions (AtomicGame.h):
+ more rounds per second, but the result depends on the scheduling. The rounds
+ and time of every thread in the last batch are kept to compare the modes.
+ 
+ Besides vanilla CFR, the regrets and strategy sums can be updated with CFR+
+ (regrets floored at zero, linear averaging) or Discounted CFR (positive and
+ negative regrets and the average strategy discounted with alpha, beta and
+ gamma). The discounts are applied at the end of every iteration: every batch
+ in the exact mode, and every batch of rounds in the sampled mode.
+ 
+ Every few batches the exploitability of the average strategies can be
+ computed exactly with BestResponse.h, and the optimization stops as soon as
+ it falls below a target.
+ 
+ The average strategies and the time series are saved every 10 batches (or
+ set_checkpoint_every()) into the output directory by a background thread
+ (CheckpointWriter.h), so that training does not wait for the disk or the
+ terminal. The whole state of the run is saved at the same
+ time in a binary checkpoint, from which an interrupted run can be resumed.
+ 
+ The wall time of every phase (dealing, ranking, regret updates, averaging,
+ I/O and exploitability) is measured per thread by a Profiler.
+
+Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
+ ********************************************************************************/
+
+using namespace std;
+
+class Regret{
+    
+public:
+    
+    // sampled: chance-sampled rounds of poker (Rounds per batch).
+    // exact: one full-width iteration over all deals per batch.
+    enum class Mode { sampled, exact };
+    
+    // vanilla: plain regret matching and uniform averaging.
+    // cfr_plus: regrets floored at zero, iteration t weighs t in the average.
+    // discounted: Discounted CFR with parameters alpha, beta and gamma.
+    enum class UpdateRule { vanilla, cfr_plus, discounted };
+    
+    // How the sampled rounds are spread over the threads.
+    // sharded: private copies of the tables, merged in a fixed order.
+    // hogwild: shared tables with lock-free atomic updates.
+    enum class Parallelism { sharded, hogwild };
+    
+    // Phases of the Profiler.
+    enum Phase { deal, rank, regret_update, averaging, io, exploitability_check };
+    
+    // Rounds played by one thread in the last batch, and the time it took.
+    struct alignas(64) ThreadStats{
+        long long rounds=0;
+        double seconds=0;
+    };
+    
+    Regret(double bank, int R, double Bet, double Ante, int E, unsigned long long Seed){
+        start_bankroll=bank;
+        Rounds=R;
+        bet=Bet;
+        ante=Ante;
+        Optimization_rounds=E;
+        seed=Seed;
+        batch=0;
+        mode=Mode::sampled;
+        parallelism=Parallelism::sharded;
+        set_update_rule(UpdateRule::vanilla);
+        set_exploitability_check(0,0);
+        rng.seed(seed,0);
+        Player.set_bankroll(start_bankroll);
+        Dealer.set_bankroll(start_bankroll);
+        writer.set_profiler(&profiler,io);
+    }
+    
+    // Regret matching: probability to act given the regrets of
+    // (act, do not act). Only positive regrets count.
+    double regret_matching(double R0, double R1){
+        if(R0<0)
+            R0=0;
+        if(R1<0)
+            R1=0;
+        double regrets_tot=R0+R1;
+        if(regrets_tot<=0)
+            return 0.5;
+        return R0/regrets_tot;
+    }
+    
+    // This function is called after each round of poker in order to update
+    // regrets and strategies counts. If at the given round of poker (played
+    // by the poker() method) the player was dealt hand "ip" and the dealer
+    // was dealt hand "id", then we need to update strategies of player
+    // and dealer when holding hands "ip" and "id", repsectively.
+    template<class G>
+    void prepare_strategies(G & player, G & dealer, int ip, int id){
+        if(update_rule==UpdateRule::cfr_plus){
+            player.floor_regret_sum(ip);
+            dealer.floor_regret_sum(id);
+        }
+        // Set Player's and Dealer's strategies
+        double p=regret_matching(player.get_regret_sum(ip,0),player.get_regret_sum(ip,1));
+        double q=regret_matching(dealer.get_regret_sum(id,0),dealer.get_regret_sum(id,1));
+        player.set_strategy(ip,p);
+        dealer.set_strategy(id,q);
+        // Add strategies to strategies sums
+        player.add_strategy_sum(ip,p,1-p);
+        dealer.add_strategy_sum(id,q,1-q);
+    }
+    
+    void prepare_strategies(int ip, int id){
+        prepare_strategies(Player,Dealer,ip,id);
+    }
+    
+    // Apply the update rule to all regrets and strategy sums of "game" at
+    // the end of iteration t (counted from 1). Scaling the strategy sums by
+    // t/(t+1) after every iteration is the linear averaging of CFR+. The
+    // strategies are not affected, regret matching ignores negative regrets
+    // and scales both positive ones by the same factor. It is called between
+    // batches, on the Game tables, after the hogwild tables have been copied
+    // back, so no thread is adding to them.
+    void discount(Game & game, int t){
+        if(update_rule==UpdateRule::vanilla)
+            return;
+        double positive=1, negative=0, average=(double) t/(t+1);
+        if(update_rule==UpdateRule::discounted){
+            positive=pow(t,alpha)/(pow(t,alpha)+1);
+            negative=pow(t,beta)/(pow(t,beta)+1);
+            average=pow((double) t/(t+1),gamma);
+        }
+        for(int k=0;k<169;++k){
+            double R0=game.get_regret_sum(k,0), R1=game.get_regret_sum(k,1);
+            game.set_regret_sum(k,R0*(R0>0 ? positive : negative),R1*(R1>0 ? positive : negative));
+            game.set_strategy_sum(k,game.get_strategy_sum(k,0)*average,game.get_strategy_sum(k,1)*average);
+        }
+    }
+    
+    void calculate_average_strategy(){
+        int j;
+        #pragma omp parallel for private(j)
+        for(j=0;j<169;++j){
+            // hands that were never dealt keep the uniform strategy
+            double pS0=Player.get_strategy_sum(j,0), pS=pS0+Player.get_strategy_sum(j,1);
+            Player.set_average_strategy(j,pS>0 ? pS0/pS : 0.5);
+            double dS0=Dealer.get_strategy_sum(j,0), dS=dS0+Dealer.get_strategy_sum(j,1);
+            Dealer.set_average_strategy(j,dS>0 ? dS0/dS : 0.5);
+        }
+    }
+    
+    // Play one round of poker between the given Player and Dealer tables,
+    // drawing the cards and actions from "rng".
+    array<int,2> poker(Game & player, Game & dealer, Rng & rng){
+        // Both player and dealer put the same ante
+        // Deal the hole cards to player and dealer
+        Deck deck(rng);
+        int c1=deck.deal_card();
+        int c2=deck.deal_card();
+        int c3=deck.deal_card();
+        int c4=deck.deal_card();
+        // strategy indexes of Player and Dealer
+        int player_strategy_index=player.strategy_index(c1,c2);
+        int dealer_strategy_index=dealer.strategy_index(c3,c4);
+        // Deal the community cards
+        int c5=deck.deal_card();
+        int c6=deck.deal_card();
+        int c7=deck.deal_card();
+        array<int,5> player_hand={c1,c2,c5,c6,c7};
+        array<int,5> dealer_hand={c3,c4,c5,c6,c7};
+        // Compare the ranks of the best hands player and dealer can claim
+        int player_rank=checkrank.findRank(player_hand);
+        int dealer_rank=checkrank.findRank(dealer_hand);
+        showdown(player,dealer,player_strategy_index,dealer_strategy_index,player_rank,dealer_rank,rng);
+        array<int,2> ret={player_strategy_index,dealer_strategy_index};
+        return ret;
+    }
+    
+    // Update the regrets of Player and Dealer for the hands they hold,
+    // given the ranks of their best hands, and play the round for the
+    // bankrolls.
+    template<class G>
+    void showdown(G & player, G & dealer, int player_strategy_index, int dealer_strategy_index,
+                  int player_rank, int dealer_rank, Rng & rng){
+        // Determine who wins
+        bool player_wins=player_rank<dealer_rank ? true : false;
+        double p=player.get_strategy(player_strategy_index); // probability for Player to bet
+        double q=dealer.get_strategy(dealer_strategy_index); // probability for Dealer to call
+        // Consider various game states, defined by who wins or whether it's a draw.
+        if(player_rank==dealer_rank){
+            // Expected value of Player's strategy given the current game state.
+            double Vp=p*(1-q)*ante;
+            player.add_regret_sum(player_strategy_index,(1-q)*ante-Vp,-Vp);
+            // Expected value of Dealer's strategy given the current game state.
+            double Vd=(1-q)*(-ante);
+            dealer.add_regret_sum(dealer_strategy_index,p*(-Vd),p*(-ante-Vd));
+        }
+        else if(player_wins){
+            // Expected value of Player's strategy given the current game state.
+            double Vp=(1-p)*ante+p*((1-q)*ante+q*(ante+bet));
+            player.add_regret_sum(player_strategy_index,(1-q)*ante+q*(ante+bet)-Vp,ante-Vp);
+            // Expected value of Dealer's strategy given the current game state.
+            double Vd=(1-q)*(-ante)+q*(-ante-bet);
+            dealer.add_regret_sum(dealer_strategy_index,p*(-ante-bet-Vd),p*(-ante-Vd));
+        }
+        else if(!player_wins){
+            // Expected value of Player's strategy given the current game state.
+            double Vp=(1-p)*(-ante)+p*((1-q)*ante+q*(-ante-bet));
+            player.add_regret_sum(player_strategy_index,(1-q)*ante+q*(-ante-bet)-Vp,-ante-Vp);
+            // Expected value of Dealer's strategy given the current game state.
+            double Vd=(1-q)*(-ante)+q*(ante+bet);
+            dealer.add_regret_sum(dealer_strategy_index,p*(ante+bet-Vd),p*(-ante-Vd));
+        }
+        // Before returning, play the actual game.
+        double is_bet=player.act(player_strategy_index,rng); // If Player bets
+        double is_call=dealer.act(dealer_strategy_index,rng); // If Dealer calls
+        if(is_bet){
+            if(is_call){
+                if(player_rank==dealer_rank)
+                    return;
+                else if(player_wins){
+                    player.change_bankroll(bet+ante);
+                    dealer.change_bankroll(-bet-ante);
+                    return;
+                }
+                else if(!player_wins){
+                    dealer.change_bankroll(bet+ante);
+                    player.change_bankroll(-bet-ante);
+                    return;
+                }
+            }
+            else{
+                player.change_bankroll(ante);
+                dealer.change_bankroll(-ante);
+                return;
+            }
+        }
+        else{
+            if(player_rank==dealer_rank)
+                return;
+            else if(player_wins){
+                player.change_bankroll(ante);
+                dealer.change_bankroll(-ante);
+                return;
+            }
+            else if(!player_wins){
+                dealer.change_bankroll(ante);
+                player.change_bankroll(-ante);
+                return;
+            }
+        }
+    }
+
+    array<int,2> poker(){
+        return poker(Player,Dealer,rng);
+    }
+    
+    // Generator of shard "s" in the current batch. Each (batch, shard) pair
+    // gets its own stream of the run seed, so that a run is reproducible
+    // for a given seed and thread count.
+    Rng shard_rng(int s){
+        return Rng(seed,((unsigned long long) (batch+1)<<32)|s);
+    }
+    
+    void play_shard(int s, int shards){
+        Game & player=player_shards[s];
+        Game & dealer=dealer_shards[s];
+        player.set_bankroll(0);
+        dealer.set_bankroll(0);
+        play_rounds(player,dealer,s,shards);
+    }
+    
+    // Play the share of thread "s" of the rounds of the batch on the given
+    // tables (a shard of its own, or the shared atomic tables).
+    // The rounds are played in blocks: the cards of a whole block are dealt
+    // first and all hands of the block are ranked with one findRanks() call.
+    template<class G>
+    void play_rounds(G & player, G & dealer, int s, int shards){
+        auto start=chrono::steady_clock::now();
+        long long rounds=(long long) Rounds;
+        long long n=rounds/shards+(s<rounds%shards ? 1 : 0);
+        Rng rng=shard_rng(s);
+        Deck deck(rng);
+        const int block=1024;
+        // cards[k*block+i] is the k-th card dealt in round i of the block:
+        // two for Player, two for Dealer, and three community cards.
+        vector<int> cards(7*block);
+        vector<int> player_ranks(block);
+        vector<int> dealer_ranks(block);
+        const int * player_cards[5]={&cards[0],&cards[block],&cards[4*block],&cards[5*block],&cards[6*block]};
+        const int * dealer_cards[5]={&cards[2*block],&cards[3*block],&cards[4*block],&cards[5*block],&cards[6*block]};
+        for(long long done=0;done<n;done+=block){
+            int m=min((long long) block,n-done);
+            {
+                Profiler::Timer timer(profiler,s,deal,m);
+                for(int i=0;i<m;++i){
+                    deck.reset();
+                    for(int k=0;k<7;++k)
+                        cards[k*block+i]=deck.deal_card();
+                }
+            }
+            {
+                Profiler::Timer timer(profiler,s,rank,2*m);
+                checkrank.findRanks(player_cards,m,player_ranks.data());
+                checkrank.findRanks(dealer_cards,m,dealer_ranks.data());
+            }
+            Profiler::Timer timer(profiler,s,regret_update,m);
+            for(int i=0;i<m;++i){
+                int ip=Game::strategy_index(cards[i],cards[block+i]);
+                int id=Game::strategy_index(cards[2*block+i],cards[3*block+i]);
+                showdown(player,dealer,ip,id,player_ranks[i],dealer_ranks[i],rng);
+                prepare_strategies(player,dealer,ip,id);
+            }
+        }
+        thread_stats[s].rounds=n;
+        thread_stats[s].seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    }
+    
+    // All threads play on the shared atomic tables, which are loaded from
+    // and stored back into Player and Dealer around the batch. The bankrolls
+    // are kept per thread and added in thread order.
+    void play_hogwild(int threads){
+        {
+            Profiler::Timer timer(profiler,0,averaging);
+            shared_player.load(Player);
+            shared_dealer.load(Dealer);
+        }
+        vector<double> player_gain(threads,0), dealer_gain(threads,0);
+        int s;
+        #pragma omp parallel for private(s) schedule(static,1)
+        for(s=0;s<threads;++s){
+            AtomicSeat player(shared_player), dealer(shared_dealer);
+            play_rounds(player,dealer,s,threads);
+            player_gain[s]=player.get_bankroll();
+            dealer_gain[s]=dealer.get_bankroll();
+        }
+        Profiler::Timer timer(profiler,0,averaging);
+        shared_player.store(Player);
+        shared_dealer.store(Dealer);
+        for(s=0;s<threads;++s){
+            Player.change_bankroll(player_gain[s]);
+            Dealer.change_bankroll(dealer_gain[s]);
+        }
+    }
+    
+    // Merge the shards back into the Player and Dealer tables. Every shard
+    // starts from the same regrets and plays its own share of the rounds,
+    // so its regret change is one estimate of the change of the batch: the
+    // changes of the shards are averaged (summing them would multiply the
+    // step of regret matching by the number of shards), while the strategy
+    // sums, which count the rounds, are added. The changes are summed shard
+    // by shard in a fixed order, so the result does not depend on how the
+    // threads were scheduled.
+    void reduce_shards(){
+        Profiler::Timer timer(profiler,0,averaging);
+        int shards=player_shards.size();
+        int k;
+        #pragma omp parallel for private(k)
+        for(k=0;k<169;++k){
+            reduce_entry(Player,player_shards,k);
+            reduce_entry(Dealer,dealer_shards,k);
+        }
+        for(int s=0;s<shards;++s){
+            Player.change_bankroll(player_shards[s].get_bankroll());
+            Dealer.change_bankroll(dealer_shards[s].get_bankroll());
+        }
+    }
+    
+    void reduce_entry(Game & game, vector<Game> & shards, int k){
+        double R0=game.get_regret_sum(k,0), R1=game.get_regret_sum(k,1);
+        double S0=game.get_strategy_sum(k,0), S1=game.get_strategy_sum(k,1);
+        double dR0=0, dR1=0, dS0=0, dS1=0;
+        for(Game & shard : shards){
+            dR0+=shard.get_regret_sum(k,0)-R0;
+            dR1+=shard.get_regret_sum(k,1)-R1;
+            dS0+=shard.get_strategy_sum(k,0)-S0;
+            dS1+=shard.get_strategy_sum(k,1)-S1;
+        }
+        dR0/=shards.size();
+        dR1/=shards.size();
+        game.add_regret_sum(k,dR0,dR1);
+        game.add_strategy_sum(k,dS0,dS1);
+        game.set_strategy(k,regret_matching(R0+dR0,R1+dR1));
+    }
+
+    // Load the equities from the cache file, or compute and cache them.
+    void load_equity(){
+        if(equity.is_built())
+            return;
+        Profiler::Timer timer(profiler,0,io);
+        if(!equity.load(equity_file)){
+            cout << "Computing the equities of all hands..." << endl;
+            equity.build(checkrank);
+            equity.save(equity_file);
+        }
+    }
+    
+    // Exact exploitability of the current average strategies, in expected
+    // value per round.
+    double exploitability(){
+        load_equity();
+        Profiler::Timer timer(profiler,0,exploitability_check);
+        calculate_average_strategy();
+        BestResponse best_response(equity,ante,bet);
+        return best_response.exploitability(Player.get_whole_average_strategy(),Dealer.get_whole_average_strategy());
+    }
+    
+    // One iteration of vanilla CFR over all deals: both seats update the
+    // regrets of all their hands with the exact counterfactual values
+    // against the current strategy of the other seat.
+    void play_exact(){
+        load_equity();
+        Profiler::Timer timer(profiler,0,regret_update,169);
+        const Game::Table & p=Player.get_whole_strategy();
+        const Game::Table & q=Dealer.get_whole_strategy();
+        Game::Table bet_value, check_value, call_value, fold_value;
+        equity.player_values(q,ante,bet,bet_value,check_value);
+        equity.dealer_values(p,ante,bet,call_value,fold_value);
+        // expected value of a round for Player
+        double value=0;
+        for(int k=0;k<169;++k){
+            double Vp=p[k]*bet_value[k]+(1-p[k])*check_value[k];
+            double Vd=q[k]*call_value[k]+(1-q[k])*fold_value[k];
+            value+=Vp;
+            Player.add_regret_sum(k,bet_value[k]-Vp,check_value[k]-Vp);
+            Dealer.add_regret_sum(k,call_value[k]-Vd,fold_value[k]-Vd);
+        }
+        for(int k=0;k<169;++k){
+            double pk=regret_matching(Player.get_regret_sum(k,0),Player.get_regret_sum(k,1));
+            double qk=regret_matching(Dealer.get_regret_sum(k,0),Dealer.get_regret_sum(k,1));
+            Player.set_strategy(k,pk);
+            Dealer.set_strategy(k,qk);
+            Player.add_strategy_sum(k,pk,1-pk);
+            Dealer.add_strategy_sum(k,qk,1-qk);
+        }
+        // bankrolls expected after a batch of Rounds rounds
+        Player.set_bankroll(start_bankroll+Rounds*value);
+        Dealer.set_bankroll(start_bankroll-Rounds*value);
+    }
+
+    // Play one batch and update the tables, without any output.
+    void run_batch(){
+        if(mode==Mode::exact)
+            play_exact();
+        else{
+            Player.set_bankroll(start_bankroll);
+            Dealer.set_bankroll(start_bankroll);
+            int threads=omp_get_max_threads();
+            thread_stats.assign(threads,ThreadStats());
+            profiler.reserve(threads);
+            if(parallelism==Parallelism::hogwild)
+                play_hogwild(threads);
+            else{
+                player_shards.assign(threads,Player);
+                dealer_shards.assign(threads,Dealer);
+                int s;
+                #pragma omp parallel for private(s) schedule(static,1)
+                for(s=0;s<threads;++s)
+                    play_shard(s,threads);
+                reduce_shards();
+            }
+        }
+        {
+            Profiler::Timer timer(profiler,0,averaging);
+            discount(Player,batch+1);
+            discount(Dealer,batch+1);
+        }
+        ++batch;
+    }
+    
+    void play(){
+        run_batch();
+        double p=Player.get_bankroll()/start_bankroll;
+        double d=Dealer.get_bankroll()/start_bankroll;
+        if(mode==Mode::exact)
+            cout << "Player's expected return is " << p << ", Dealer's expected return is " << d << endl;
+        else
+            cout << "Player's return is " << p << ", Dealer's return is " << d << endl;
+        player_bankroll.push_back(p);
+        dealer_bankroll.push_back(d);
+    }
+    
+    // Rounds per second of every thread in the last batch.
+    void print_throughput(){
+        double total=0;
+        cout << "Rounds per second by thread:";
+        for(ThreadStats & t : thread_stats){
+            double r=t.seconds>0 ? t.rounds/t.seconds : 0;
+            total+=r;
+            cout << " " << r;
+        }
+        cout << endl << "Total rounds per second: " << total << endl;
+    }
+    
+    // Batches run one after the other; the rounds inside each batch are
+    // spread over the threads by play(). The optimization stops early when
+    // the exploitability checked every check_every batches reaches the target.
+    void optimize(){
+        for(int i=batch;i<Optimization_rounds;++i){
+            cout << "i=" << i << endl;
+            play();
+            if(check_every>0&&(i+1)%check_every==0){
+                double e=exploitability();
+                cout << "Exploitability is " << e << endl;
+                exploitability_series.push_back(e);
+                if(e<=target_exploitability){
+                    cout << "Target exploitability reached after " << i+1 << " batches" << endl;
+                    break;
+                }
+            }
+            if(checkpoint_every>0&&i%checkpoint_every==0)
+                checkpoint(true);
+        }
+        checkpoint(true);
+        {
+            Profiler::Timer timer(profiler,0,io);
+            writer.flush();
+        }
+        if(mode==Mode::sampled)
+            print_throughput();
+    }
+
+    void set_mode(Mode m){
+        mode=m;
+    }
+    
+    Mode get_mode(){
+        return mode;
+    }
+    
+    // The default discounts are the ones recommended for Discounted CFR.
+    void set_update_rule(UpdateRule r, double Alpha=1.5, double Beta=0, double Gamma=2){
+        update_rule=r;
+        alpha=Alpha;
+        beta=Beta;
+        gamma=Gamma;
+    }
+    
+    UpdateRule get_update_rule(){
+        return update_rule;
+    }
+    
+    void set_parallelism(Parallelism p){
+        parallelism=p;
+    }
+    
+    Parallelism get_parallelism(){
+        return parallelism;
+    }
+    
+    const vector<ThreadStats> & get_thread_stats(){
+        return thread_stats;
+    }
+    
+    Profiler & get_profiler(){
+        return profiler;
+    }
+    
+    // Compute the exploitability every "every" batches (0 = never) and stop
+    // when it is at most "target".
+    void set_exploitability_check(int every, double target){
+        check_every=every;
+        target_exploitability=target;
+    }
+    
+    // Hand a snapshot of the average strategies and of the time series to
+    // the background writer, which saves them (and prints the strategies if
+    // "print") while training goes on.
+    void checkpoint(bool print){
+        {
+            Profiler::Timer timer(profiler,0,averaging);
+            calculate_average_strategy();
+        }
+        Profiler::Timer timer(profiler,0,io);
+        CheckpointWriter::Snapshot snapshot;
+        snapshot.player_strategy=Player.get_whole_average_strategy();
+        snapshot.dealer_strategy=Dealer.get_whole_average_strategy();
+        snapshot.player_bankroll=player_bankroll;
+        snapshot.dealer_bankroll=dealer_bankroll;
+        snapshot.exploitability=exploitability_series;
+        snapshot.print=print;
+        snapshot.state_file=checkpoint_file;
+        snapshot.state=save_state();
+        writer.submit(move(snapshot));
+    }
+    
+    // Binary checkpoint of the whole run: the settings (with the number of
+    // threads and the parallel mode, on which the shard streams depend), the
+    // batch counter, the seed and the state of rng, all the tables of both seats, and the
+    // time series. A 24-byte header (magic "CFRCKPT", version, checksum of
+    // the rest) is followed by fixed-size fields and then by the series,
+    // so loading costs the same at any point of the run.
+    vector<char> save_state(){
+        vector<char> b;
+        put(b,seed);
+        put(b,(long long) batch);
+        put(b,start_bankroll);
+        put(b,Rounds);
+        put(b,bet);
+        put(b,ante);
+        put(b,(int) mode);
+        put(b,(int) update_rule);
+        put(b,omp_get_max_threads());
+        put(b,(int) parallelism);
+        put(b,alpha);
+        put(b,beta);
+        put(b,gamma);
+        put(b,rng.get_state());
+        put_game(b,Player);
+        put_game(b,Dealer);
+        put_series(b,player_bankroll);
+        put_series(b,dealer_bankroll);
+        put_series(b,exploitability_series);
+        vector<char> file;
+        file.insert(file.end(),checkpoint_magic,checkpoint_magic+8);
+        put(file,checkpoint_version);
+        put(file,(unsigned) 0);
+        put(file,checksum(b));
+        file.insert(file.end(),b.begin(),b.end());
+        return file;
+    }
+    
+    // Restore the run saved in "file". Returns false, and leaves the run
+    // unchanged, if the file cannot be read or is not a valid checkpoint, or
+    // if a sampled run does not have the same number of threads and
+    // parallel mode, since it would then not continue the saved run exactly.
+    bool load_state(const string & file){
+        ifstream is(file,ios::binary);
+        if(!is){
+            cout << "Cannot open checkpoint " << file << endl;
+            return false;
+        }
+        vector<char> b((istreambuf_iterator<char>(is)),istreambuf_iterator<char>());
+        size_t pos=8;
+        unsigned version=0, reserved=0;
+        unsigned long long sum=0;
+        if(b.size()<24||memcmp(b.data(),checkpoint_magic,8)!=0||!get(b,pos,version)||!get(b,pos,reserved)||!get(b,pos,sum)){
+            cout << file << " is not a checkpoint" << endl;
+            return false;
+        }
+        if(version!=checkpoint_version){
+            cout << file << " has version " << version << ", expected " << checkpoint_version << endl;
+            return false;
+        }
+        if(checksum(vector<char>(b.begin()+24,b.end()))!=sum){
+            cout << file << " is corrupted (wrong checksum)" << endl;
+            return false;
+        }
+        unsigned long long s;
+        long long t;
+        double bank, R, Bet, Ante, Alpha, Beta, Gamma;
+        int m, r, threads, p;
+        array<unsigned long long,4> rng_state;
+        Game player, dealer;
+        vector<double> player_series, dealer_series, exploitability;
+        bool ok=get(b,pos,s)&&get(b,pos,t)&&get(b,pos,bank)&&get(b,pos,R)&&get(b,pos,Bet)&&get(b,pos,Ante)
+            &&get(b,pos,m)&&get(b,pos,r)&&get(b,pos,threads)&&get(b,pos,p)&&get(b,pos,Alpha)&&get(b,pos,Beta)&&get(b,pos,Gamma)&&get(b,pos,rng_state)
+            &&get_game(b,pos,player)&&get_game(b,pos,dealer)
+            &&get_series(b,pos,player_series)&&get_series(b,pos,dealer_series)&&get_series(b,pos,exploitability);
+        if(!ok||pos!=b.size()){
+            cout << file << " is truncated" << endl;
+            return false;
+        }
+        // the exact mode does not depend on the threads
+        if((Mode) m==Mode::sampled&&(threads!=omp_get_max_threads()||p!=(int) parallelism)){
+            cout << file << " was saved by a run with " << threads << " threads in "
+                << parallelism_name((Parallelism) p) << " mode," << endl;
+            cout << "resume it with --threads " << threads
+                << " --parallel " << parallelism_name((Parallelism) p) << endl;
+            return false;
+        }
+        seed=s;
+        batch=t;
+        start_bankroll=bank;
+        Rounds=R;
+        bet=Bet;
+        ante=Ante;
+        mode=(Mode) m;
+        set_update_rule((UpdateRule) r,Alpha,Beta,Gamma);
+        rng.set_state(rng_state);
+        Player=player;
+        Dealer=dealer;
+        player_bankroll=player_series;
+        dealer_bankroll=dealer_series;
+        exploitability_series=exploitability;
+        return true;
+    }
+    
+    static const char * parallelism_name(Parallelism p){
+        return p==Parallelism::hogwild ? "hogwild" : "sharded";
+    }
+    
+    void set_checkpoint_file(const string & file){
+        checkpoint_file=file;
+    }
+    
+    // Save a checkpoint every "every" batches (0 = only at the end).
+    void set_checkpoint_every(int every){
+        checkpoint_every=every;
+    }
+    
+    // Directory of the CSV files and of the checkpoint, which must exist.
+    void set_output_dir(const string & dir){
+        writer.set_directory(dir);
+        checkpoint_file=CheckpointWriter::path(dir,"checkpoint.bin");
+    }
+    
+    void set_equity_file(const string & file){
+        equity_file=file;
+    }
+    
+    const vector<double> & get_player_bankroll(){
+        return player_bankroll;
+    }
+    
+    const vector<double> & get_dealer_bankroll(){
+        return dealer_bankroll;
+    }
+    
+    const vector<double> & get_exploitability_series(){
+        return exploitability_series;
+    }
+    
+    int get_batch(){
+        return batch;
+    }
+    
+    unsigned long long get_seed(){
+        return seed;
+    }
+    
+    int get_rounds(){
+        return Rounds;
+    }
+    
+private:
+    
+    template<class T>
+    static void put(vector<char> & b, const T & x){
+        const char * p=(const char *) &x;
+        b.insert(b.end(),p,p+sizeof(T));
+    }
+    
+    template<class T>
+    static bool get(const vector<char> & b, size_t & pos, T & x){
+        if(pos+sizeof(T)>b.size())
+            return false;
+        memcpy(&x,b.data()+pos,sizeof(T));
+        pos+=sizeof(T);
+        return true;
+    }
+    
+    static void put_series(vector<char> & b, const vector<double> & v){
+        put(b,(unsigned long long) v.size());
+        const char * p=(const char *) v.data();
+        b.insert(b.end(),p,p+v.size()*sizeof(double));
+    }
+    
+    static bool get_series(const vector<char> & b, size_t & pos, vector<double> & v){
+        unsigned long long n;
+        if(!get(b,pos,n)||n>(b.size()-pos)/sizeof(double))
+            return false;
+        v.resize(n);
+        memcpy(v.data(),b.data()+pos,n*sizeof(double));
+        pos+=n*sizeof(double);
+        return true;
+    }
+    
+    static void put_game(vector<char> & b, Game & game){
+        put(b,game.get_whole_strategy());
+        for(int a=0;a<2;++a){
+            put(b,game.get_whole_regret_sum(a));
+            put(b,game.get_whole_strategy_sum(a));
+        }
+        put(b,game.get_bankroll());
+    }
+    
+    static bool get_game(const vector<char> & b, size_t & pos, Game & game){
+        Game::Table strategy, regret_sum[2], strategy_sum[2];
+        double bankroll;
+        if(!get(b,pos,strategy))
+            return false;
+        for(int a=0;a<2;++a)
+            if(!get(b,pos,regret_sum[a])||!get(b,pos,strategy_sum[a]))
+                return false;
+        if(!get(b,pos,bankroll))
+            return false;
+        for(int k=0;k<169;++k){
+            game.set_strategy(k,strategy[k]);
+            game.set_regret_sum(k,regret_sum[0][k],regret_sum[1][k]);
+            game.set_strategy_sum(k,strategy_sum[0][k],strategy_sum[1][k]);
+        }
+        game.set_bankroll(bankroll);
+        return true;
+    }
+    
+    // FNV-1a of the payload of a checkpoint.
+    static unsigned long long checksum(const vector<char> & b){
+        unsigned long long h=0xCBF29CE484222325ULL;
+        for(char c : b){
+            h^=(unsigned char) c;
+            h*=0x100000001B3ULL;
+        }
+        return h;
+    }
+    
+    static constexpr char checkpoint_magic[8]="CFRCKPT";
+    static constexpr unsigned checkpoint_version=2;
+    
+    double start_bankroll;
+    double Rounds;
+    double bet;
+    double ante;
+    int Optimization_rounds;
+    unsigned long long seed;
+    int batch;
+    Mode mode;
+    Parallelism parallelism;
+    UpdateRule update_rule;
+    double alpha;
+    double beta;
+    double gamma;
+    int check_every;
+    double target_exploitability;
+
+    Game Player;
+    Game Dealer;
+    
+    // Private copies of Player and Dealer, one per thread.
+    vector<Game> player_shards;
+    vector<Game> dealer_shards;
+    
+    // Tables shared by all threads in the hogwild mode.
+    AtomicTable shared_player;
+    AtomicTable shared_dealer;
+    vector<ThreadStats> thread_stats;
+    Profiler profiler{{"deal","rank","regret_update","averaging","io","exploitability"}};
+    
+    Rng rng;
+
+    CheckRank checkrank;
+    Equity equity;
+    string equity_file="equity.bin";
+
+    vector<double> player_bankroll;
+    vector<double> dealer_bankroll;
+    vector<double> exploitability_series;
+    
+    CheckpointWriter writer;
+    string checkpoint_file="checkpoint.bin";
+    int checkpoint_every=10;
+    
+};
@@ -27,8 +27,13 @@ Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
 #include <fstream>
 #include <unordered_map>
 #include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
+#include "Rng.h"
 #include "Deck.h"
+#include "RankTable.h"
 #include "CheckRank.h"
 #include "Game.h"
 
@@ -38,12 +43,13 @@ class Regret{
     
 public:
     
-    Regret(double bank, int R, double Bet, double Ante, int E){
+    Regret(double bank, int R, double Bet, double Ante, int E, unsigned long long Seed){
         start_bankroll=bank;
         Rounds=R;
         bet=Bet;
         ante=Ante;
         Optimization_rounds=E;
+        rng.seed(Seed,0);
         Player.set_bankroll(start_bankroll);
         Dealer.set_bankroll(start_bankroll);
     }
@@ -54,12 +60,10 @@ public:
     // was dealt hand "id", then we need to update strategies of player
     // and dealer when holding hands "ip" and "id", repsectively.
     void prepare_strategies(int ip, int id){
-        vector<double> player_regrets=Player.get_regret_sum(ip);
-        vector<double> dealer_regrets=Dealer.get_regret_sum(id);
-        double pR0=player_regrets[0];
-        double pR1=player_regrets[1];
-        double dR0=dealer_regrets[0];
-        double dR1=dealer_regrets[1];
+        double pR0=Player.get_regret_sum(ip,0);
+        double pR1=Player.get_regret_sum(ip,1);
+        double dR0=Dealer.get_regret_sum(id,0);
+        double dR1=Dealer.get_regret_sum(id,1);
         if(pR0<0)
             pR0=0;
         if(pR1<0)
@@ -86,52 +90,41 @@ public:
         }
         // Add strategies to strategies sums
         // Player.
-        vector<double> player_strat_sum=Player.get_strategy_sum(ip);
         double p=Player.get_strategy(ip);
         double p_tilde=1-p;
-        player_strat_sum[0]+=p;
-        player_strat_sum[1]+=p_tilde;
-        Player.set_strategy_sum(ip,player_strat_sum);
+        Player.add_strategy_sum(ip,p,p_tilde);
         // Dealer.
-        vector<double> dealer_strat_sum=Dealer.get_strategy_sum(id);
         double q=Dealer.get_strategy(id);
         double q_tilde=1-q;
-        dealer_strat_sum[0]+=q;
-        dealer_strat_sum[1]+=q_tilde;
-        Dealer.set_strategy_sum(id,dealer_strat_sum);
+        Dealer.add_strategy_sum(id,q,q_tilde);
     }
     
     void calculate_average_strategy(){
         for(int j=0;j<169;++j){
-            vector<double> player_strat_sum=Player.get_strategy_sum(j);
-            Player.set_average_strategy(j,player_strat_sum[0]/(player_strat_sum[0]+player_strat_sum[1]));
-            vector<double> dealer_strat_sum=Dealer.get_strategy_sum(j);
-            Dealer.set_average_strategy(j,dealer_strat_sum[0]/(dealer_strat_sum[0]+dealer_strat_sum[1]));
+            double pS0=Player.get_strategy_sum(j,0);
+            Player.set_average_strategy(j,pS0/(pS0+Player.get_strategy_sum(j,1)));
+            double dS0=Dealer.get_strategy_sum(j,0);
+            Dealer.set_average_strategy(j,dS0/(dS0+Dealer.get_strategy_sum(j,1)));
         }
     }
     
-    vector<int> poker(){
+    array<int,2> poker(){
         // Both player and dealer put the same ante
         // Deal the hole cards to player and dealer
-        Deck deck;
+        deck.reset();
         int c1=deck.deal_card();
         int c2=deck.deal_card();
         int c3=deck.deal_card();
         int c4=deck.deal_card();
-        vector<int> player_hand={c1,c2};
-        vector<int> dealer_hand={c3,c4};
         // strategy indexes of Player and Dealer
-        int player_strategy_index=Player.strategy_index(player_hand);
-        int dealer_strategy_index=Dealer.strategy_index(dealer_hand);
-        // current regrets of Player and Dealer
-        vector<double> player_regret=Player.get_regret_sum(player_strategy_index);
-        vector<double> dealer_regret=Dealer.get_regret_sum(dealer_strategy_index);
+        int player_strategy_index=Player.strategy_index(c1,c2);
+        int dealer_strategy_index=Dealer.strategy_index(c3,c4);
         // Deal the community cards
-        for(int i=0;i<3;++i){
-            int c=deck.deal_card();
-            player_hand.push_back(c);
-            dealer_hand.push_back(c);
-        }
+        int c5=deck.deal_card();
+        int c6=deck.deal_card();
+        int c7=deck.deal_card();
+        array<int,5> player_hand={c1,c2,c5,c6,c7};
+        array<int,5> dealer_hand={c3,c4,c5,c6,c7};
         // Compare the ranks of the best hands player and dealer can claim
         int player_rank=checkrank.findRank(player_hand);
         int dealer_rank=checkrank.findRank(dealer_hand);
@@ -143,37 +136,31 @@ public:
         if(player_rank==dealer_rank){
             // Expected value of Player's strategy given the current game state.
             double Vp=p*(1-q)*ante;
-            vector<double> pr={player_regret[0]+(1-q)*ante-Vp,player_regret[1]-Vp};
-            Player.set_regret_sum(player_strategy_index,pr);
+            Player.add_regret_sum(player_strategy_index,(1-q)*ante-Vp,-Vp);
             // Expected value of Dealer's strategy given the current game state.
             double Vd=(1-q)*(-ante);
-            vector<double> dr={dealer_regret[0]+p*(-Vd),dealer_regret[1]+p*(-ante-Vd)};
-            Dealer.set_regret_sum(dealer_strategy_index,dr);
+            Dealer.add_regret_sum(dealer_strategy_index,p*(-Vd),p*(-ante-Vd));
         }
         else if(player_wins){
             // Expected value of Player's strategy given the current game state.
             double Vp=(1-p)*ante+p*((1-q)*ante+q*(ante+bet));
-            vector<double> pr={player_regret[0]+(1-q)*ante+q*(ante+bet)-Vp,player_regret[1]+ante-Vp};
-            Player.set_regret_sum(player_strategy_index,pr);
+            Player.add_regret_sum(player_strategy_index,(1-q)*ante+q*(ante+bet)-Vp,ante-Vp);
             // Expected value of Dealer's strategy given the current game state.
             double Vd=(1-q)*(-ante)+q*(-ante-bet);
-            vector<double> dr={dealer_regret[0]+p*(-ante-bet-Vd),dealer_regret[1]+p*(-ante-Vd)};
-            Dealer.set_regret_sum(dealer_strategy_index,dr);
+            Dealer.add_regret_sum(dealer_strategy_index,p*(-ante-bet-Vd),p*(-ante-Vd));
         }
         else if(!player_wins){
             // Expected value of Player's strategy given the current game state.
             double Vp=(1-p)*(-ante)+p*((1-q)*ante+q*(-ante-bet));
-            vector<double> pr={player_regret[0]+(1-q)*ante+q*(-ante-bet)-Vp,player_regret[1]-ante-Vp};
-            Player.set_regret_sum(player_strategy_index,pr);
+            Player.add_regret_sum(player_strategy_index,(1-q)*ante+q*(-ante-bet)-Vp,-ante-Vp);
             // Expected value of Dealer's strategy given the current game state.
             double Vd=(1-q)*(-ante)+q*(ante+bet);
-            vector<double> dr={dealer_regret[0]+p*(ante+bet-Vd),dealer_regret[1]+p*(-ante-Vd)};
-            Dealer.set_regret_sum(dealer_strategy_index,dr);
+            Dealer.add_regret_sum(dealer_strategy_index,p*(ante+bet-Vd),p*(-ante-Vd));
         }
-        vector<int> ret={player_strategy_index,dealer_strategy_index};
+        array<int,2> ret={player_strategy_index,dealer_strategy_index};
         // Before returning, play the actual game.
-        double is_bet=Player.act(player_hand); // If Player bets
-        double is_call=Dealer.act(dealer_hand); // If Dealer calls
+        double is_bet=Player.act(player_strategy_index,rng); // If Player bets
+        double is_call=Dealer.act(dealer_strategy_index,rng); // If Dealer calls
         if(is_bet){
             if(is_call){
                 if(player_rank==dealer_rank)
@@ -215,7 +202,7 @@ public:
     void play(){
         Player.set_bankroll(start_bankroll);
         Dealer.set_bankroll(start_bankroll);
-        vector<int> players;
+        array<int,2> players;
         for(int i=0;i<Rounds;++i){
             players=poker();
             prepare_strategies(players[0],players[1]);
@@ -253,7 +240,7 @@ public:
     
     void save_average_strategy(){
         // Save Player's strategy
-        vector<double> player_strategy=Player.get_whole_average_strategy();
+        const Game::Table & player_strategy=Player.get_whole_average_strategy();
         ofstream file_player;
         file_player.open("strategy_player.csv");
         for(int n=0; n<168; n++){
@@ -263,7 +250,7 @@ public:
         file_player << player_strategy[168];
         file_player.close();
         // Save Dealer's strategy
-        vector<double> dealer_strategy=Dealer.get_whole_average_strategy();
+        const Game::Table & dealer_strategy=Dealer.get_whole_average_strategy();
         ofstream file_dealer;
         file_dealer.open("strategy_dealer.csv");
         for(int n=0; n<168; n++){
@@ -307,6 +294,9 @@ private:
 
     Game Player;
     Game Dealer;
+    
+    Rng rng;
+    Deck deck{rng};
 
     CheckRank checkrank;
 
@@ -317,7 +307,9 @@ private:
 
 int main(){
     
-    srand(10000*time(0));
+    // seed of the training run
+    unsigned long long seed=time(0);
+    cout<<"Seed: "<<seed<<endl;
     
     //bankroll reset at the beginning of each batch of self-training
     //double start_bankroll=1000000.0;
@@ -338,7 +330,7 @@ int main(){
 
     clock_t time_req; time_req = clock();
     
-    Regret regret(start_bankroll,game_rounds,bet,ante,optimization_rounds);
+    Regret regret(start_bankroll,game_rounds,bet,ante,optimization_rounds,seed);
     
     regret.optimize();
 
@@ -0,0 +1,116 @@
+/********************************************************************************
+ 
+ Counterfactual Regret Minimization by walking the whole tree of a
+ two-player ExtensiveGame, with reach probabilities.
+ 
+ Each iteration walks every history once, passing down the probability
+ that each player, and chance, plays to it. At a history of player p the
+ walk returns the values of both players; the regret of each action of the
+ information set is increased by the value of the action minus the value
+ of the strategy, weighted by the probability that the other player and
+ chance reach the history (the counterfactual reach), and the strategy sum
+ by the strategy weighted by the reach of p. The strategies are updated by
+ regret matching once the walk is over, so that the whole iteration plays
+ the same profile (simultaneous updates). The average strategies converge
+ to a Nash equilibrium in two-player zero-sum games.
+ 
+ The tree is built once (GameTree.h) with the information sets numbered in
+ an InfosetStore, so an iteration walks the nodes by index and reads and
+ updates the regrets and strategies of an information set in the arena of
+ the store, without looking up keys or calling the game.
+ 
+ Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+template<class G>
+class CFR{
+    
+public:
+    
+    typedef ExtensiveGame::State State;
+    typedef ExtensiveGame::InfosetKey InfosetKey;
+    
+    CFR(const G & g) : game(g){
+        iteration=0;
+        tree.build(game,store);
+        store.allocate();
+    }
+    
+    void train(long long iterations){
+        for(long long i=0;i<iterations;++i){
+            walk(0,{1,1},1);
+            for(int id=0;id<store.size();++id)
+                regret_matching(store.regret_sum(id),store.strategy(id),store.actions(id));
+            ++iteration;
+        }
+    }
+    
+    // Average strategy of every information set.
+    Policy average_policy() const{
+        return store.average_policy();
+    }
+    
+    const InfosetStore & get_store() const{
+        return store;
+    }
+    
+    const GameTree & get_tree() const{
+        return tree;
+    }
+    
+    size_t memory_bytes() const{
+        return store.memory_bytes()+tree.memory_bytes();
+    }
+    
+    long long get_iteration() const{
+        return iteration;
+    }
+    
+private:
+    
+    // Values of both players at node i, where player q reaches it with
+    // probability reach[q] and chance with probability chance_reach.
+    array<double,2> walk(int i, const array<double,2> & reach, double chance_reach){
+        const GameTree::Node & node=tree.node(i);
+        if(node.player==GameTree::terminal)
+            return {node.utility[0],node.utility[1]};
+        int n=node.children;
+        int p=node.player;
+        array<double,2> value={0,0};
+        if(p==ExtensiveGame::chance){
+            for(int a=0;a<n;++a){
+                double probability=tree.node(node.first_child+a).probability;
+                array<double,2> child=walk(node.first_child+a,reach,chance_reach*probability);
+                value[0]+=probability*child[0];
+                value[1]+=probability*child[1];
+            }
+            return value;
+        }
+        double * regret_sum=store.regret_sum(node.infoset);
+        double * strategy=store.strategy(node.infoset);
+        double * strategy_sum=store.strategy_sum(node.infoset);
+        array<array<double,2>,ExtensiveGame::max_actions> children;
+        for(int a=0;a<n;++a){
+            array<double,2> child_reach=reach;
+            child_reach[p]*=strategy[a];
+            children[a]=walk(node.first_child+a,child_reach,chance_reach);
+            value[0]+=strategy[a]*children[a][0];
+            value[1]+=strategy[a]*children[a][1];
+        }
+        double counterfactual_reach=reach[1-p]*chance_reach;
+        for(int a=0;a<n;++a){
+            regret_sum[a]+=counterfactual_reach*(children[a][p]-value[p]);
+            strategy_sum[a]+=reach[p]*strategy[a];
+        }
+        return value;
+    }
+    
+    const G & game;
+    long long iteration;
+    GameTree tree;
+    InfosetStore store; // information sets
+    
+};
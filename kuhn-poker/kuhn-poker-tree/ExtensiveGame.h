@@ -0,0 +1,84 @@
+/********************************************************************************
+ 
+ Interface of an extensive-form game for the tree-walking CFR of CFR.h: a
+ tree of histories, each one a node where a player (or chance) chooses one
+ of a few actions, down to terminal histories with a payoff for every
+ player.
+ 
+ A history is packed into one integer: the action taken at depth i is
+ stored in the bits [i*action_bits, (i+1)*action_bits), and the length is
+ kept next to it, so a State is two words, cheap to copy down the
+ recursion. Chance outcomes are actions of the chance player like any
+ other. Each game maps a history to the compact integer key of the
+ information set of the player to act: the histories that the player
+ cannot tell apart (because they differ only in the private information
+ of others) have the same key.
+ 
+ The games derive from ExtensiveGame and are final, so that CFR<G>, a
+ template on the game, calls them without virtual dispatch.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class ExtensiveGame{
+    
+public:
+    
+    typedef unsigned long long History;
+    typedef unsigned long long InfosetKey;
+    
+    static const int action_bits=3;
+    static const int max_actions=1<<action_bits;
+    static const int max_depth=64/action_bits;
+    static const int chance=-1;
+    
+    struct State{
+        History history=0;
+        int length=0;
+        
+        // action taken at depth i
+        int action(int i) const{
+            return (history>>(action_bits*i))&(max_actions-1);
+        }
+        
+        State next(int a) const{
+            State s;
+            s.history=history|((History) a<<(action_bits*length));
+            s.length=length+1;
+            return s;
+        }
+    };
+    
+    virtual ~ExtensiveGame(){}
+    
+    virtual int num_players() const=0;
+    
+    virtual State root() const{
+        return State();
+    }
+    
+    virtual bool is_terminal(const State & s) const=0;
+    
+    // Player to act at a non-terminal history, or chance.
+    virtual int player(const State & s) const=0;
+    
+    virtual int num_actions(const State & s) const=0;
+    
+    // Probability of chance action "a" at a chance history.
+    virtual double chance_probability(const State & s, int a) const=0;
+    
+    // Payoff of player "p" at a terminal history.
+    virtual double utility(const State & s, int p) const=0;
+    
+    // Information set of the player to act at a non-terminal, non-chance
+    // history.
+    virtual InfosetKey infoset_key(const State & s) const=0;
+    
+    // Readable name of an information set, for printing strategies.
+    virtual string infoset_name(InfosetKey key) const=0;
+    
+    // Names of the actions of an information set.
+    virtual string action_name(InfosetKey key, int a) const=0;
+    
+};
@@ -0,0 +1,80 @@
+/********************************************************************************
+ 
+ The tree of an ExtensiveGame, built once into a flat array of nodes so
+ that CFR walks it by index without calling the game: the children of a
+ node are consecutive, every decision node holds the id of its information
+ set in an InfosetStore, every node the chance probability of the action
+ leading to it (1 after a player action), and every terminal node the
+ payoffs of both players.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class GameTree{
+    
+public:
+    
+    struct Node{
+        int player; // ExtensiveGame::chance at chance nodes, -2 at terminal nodes
+        int infoset; // id in the InfosetStore, -1 if not a decision node
+        int first_child;
+        int children;
+        double probability; // chance probability of the action leading here
+        double utility[2]; // payoffs at a terminal node
+    };
+    
+    static const int terminal=-2;
+    
+    // Builds the tree of "game", adding its information sets to "store".
+    template<class G>
+    void build(const G & game, InfosetStore & store){
+        nodes.assign(1,Node());
+        nodes[0].probability=1;
+        expand(game,store,0,game.root());
+    }
+    
+    const Node & node(int i) const{
+        return nodes[i];
+    }
+    
+    int size() const{
+        return nodes.size();
+    }
+    
+    size_t memory_bytes() const{
+        return nodes.size()*sizeof(Node);
+    }
+    
+private:
+    
+    template<class G>
+    void expand(const G & game, InfosetStore & store, int i, const ExtensiveGame::State & s){
+        nodes[i].infoset=-1;
+        nodes[i].first_child=0;
+        nodes[i].children=0;
+        nodes[i].utility[0]=nodes[i].utility[1]=0;
+        if(game.is_terminal(s)){
+            nodes[i].player=terminal;
+            nodes[i].utility[0]=game.utility(s,0);
+            nodes[i].utility[1]=game.utility(s,1);
+            return;
+        }
+        int n=game.num_actions(s);
+        int p=game.player(s);
+        nodes[i].player=p;
+        if(p!=ExtensiveGame::chance)
+            nodes[i].infoset=store.add(game.infoset_key(s),n);
+        int first=nodes.size();
+        nodes[i].first_child=first;
+        nodes[i].children=n;
+        nodes.resize(first+n);
+        for(int a=0;a<n;++a){
+            nodes[first+a].probability=p==ExtensiveGame::chance ? game.chance_probability(s,a) : 1;
+            expand(game,store,first+a,s.next(a));
+        }
+    }
+    
+    vector<Node> nodes;
+    
+};
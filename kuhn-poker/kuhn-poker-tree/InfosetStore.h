@@ -0,0 +1,156 @@
+/********************************************************************************
+ 
+ Storage of the information sets of a game: each information set gets a
+ dense integer id when it is added, while the game tree is built, and its
+ regret sums, current strategy and strategy sums live in one arena: a
+ single array holding, for every id in turn, a block of 3*n values for its
+ n actions (regrets, then strategy, then strategy sums). Once the id is
+ known, reaching the data of an information set is index arithmetic on
+ offsets[id]; the three arrays of a node are adjacent, on one or two cache
+ lines for a few actions, and there is no per-node allocation, so the
+ memory is 24 bytes per action plus an offset and a key per information
+ set.
+ 
+ The map from keys to ids is only used to build the tree and by the
+ traversals that do not walk a prebuilt tree (MCCFR.h), which number the
+ information sets with add_infosets() and keep per-thread copies of the
+ arena, at the same offsets.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+// Average strategy of every information set.
+typedef unordered_map<ExtensiveGame::InfosetKey,vector<double>> Policy;
+
+// The strategy is proportional to the positive regrets, uniform if there
+// are none.
+inline void regret_matching(const double * regret_sum, double * strategy, int n){
+    double total=0;
+    for(int a=0;a<n;++a){
+        strategy[a]=max(regret_sum[a],0.0);
+        total+=strategy[a];
+    }
+    for(int a=0;a<n;++a)
+        strategy[a]=total>0 ? strategy[a]/total : 1.0/n;
+}
+
+class InfosetStore{
+    
+public:
+    
+    typedef ExtensiveGame::InfosetKey InfosetKey;
+    
+    // Id of the information set "key" with n actions, added if new.
+    int add(InfosetKey key, int n){
+        auto found=ids.find(key);
+        if(found!=ids.end())
+            return found->second;
+        int id=keys.size();
+        ids[key]=id;
+        keys.push_back(key);
+        offsets.push_back(offsets.back()+3*n);
+        return id;
+    }
+    
+    // Adds all the information sets of "game", walking its tree without
+    // keeping it.
+    template<class G>
+    void add_infosets(const G & game){
+        add_infosets(game,game.root());
+    }
+    
+    // Id of the information set "key", or -1 if unknown.
+    int find(InfosetKey key) const{
+        auto found=ids.find(key);
+        return found==ids.end() ? -1 : found->second;
+    }
+    
+    // Makes the arena for the information sets added so far: zero regrets
+    // and strategy sums, uniform strategies.
+    void allocate(){
+        arena.assign(offsets.back(),0);
+        for(int id=0;id<size();++id){
+            int n=actions(id);
+            fill(strategy(id),strategy(id)+n,1.0/n);
+        }
+    }
+    
+    int size() const{
+        return keys.size();
+    }
+    
+    int actions(int id) const{
+        return (offsets[id+1]-offsets[id])/3;
+    }
+    
+    InfosetKey key(int id) const{
+        return keys[id];
+    }
+    
+    double * regret_sum(int id){
+        return arena.data()+offsets[id];
+    }
+    
+    double * strategy(int id){
+        return arena.data()+offsets[id]+actions(id);
+    }
+    
+    double * strategy_sum(int id){
+        return arena.data()+offsets[id]+2*actions(id);
+    }
+    
+    const double * strategy_sum(int id) const{
+        return arena.data()+offsets[id]+2*actions(id);
+    }
+    
+    // Start of the block of id in the arena.
+    long long offset(int id) const{
+        return offsets[id];
+    }
+    
+    vector<double> & get_arena(){
+        return arena;
+    }
+    
+    // Average strategy of every information set.
+    Policy average_policy() const{
+        Policy policy;
+        for(int id=0;id<size();++id){
+            int n=actions(id);
+            const double * sums=strategy_sum(id);
+            vector<double> & average=policy[key(id)];
+            average.resize(n);
+            double total=0;
+            for(int a=0;a<n;++a)
+                total+=sums[a];
+            for(int a=0;a<n;++a)
+                average[a]=total>0 ? sums[a]/total : 1.0/n;
+        }
+        return policy;
+    }
+    
+    // Bytes of the arena, offsets and keys (not of the key map).
+    size_t memory_bytes() const{
+        return arena.size()*sizeof(double)+offsets.size()*sizeof(long long)+keys.size()*sizeof(InfosetKey);
+    }
+    
+private:
+    
+    template<class G>
+    void add_infosets(const G & game, const ExtensiveGame::State & s){
+        if(game.is_terminal(s))
+            return;
+        int n=game.num_actions(s);
+        if(game.player(s)!=ExtensiveGame::chance)
+            add(game.infoset_key(s),n);
+        for(int a=0;a<n;++a)
+            add_infosets(game,s.next(a));
+    }
+    
+    vector<InfosetKey> keys; // key of every id
+    vector<long long> offsets={0}; // start of the block of every id in the arena, and the end
+    vector<double> arena;
+    unordered_map<InfosetKey,int> ids;
+    
+};
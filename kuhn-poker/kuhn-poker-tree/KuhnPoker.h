@@ -0,0 +1,91 @@
+/********************************************************************************
+ 
+ Three-card Kuhn poker as an ExtensiveGame.
+ 
+ The deck is Jack, Queen, King; both players ante 1 and are dealt one card
+ each. Player 0 acts first: it can pass or bet 1. After a pass, player 1 can
+ pass (showdown for 1) or bet, and then player 0 folds or calls. After a
+ bet, the other player folds (losing the ante) or calls (showdown for 2).
+ The value of the game for player 0 is -1/18.
+ 
+ History: the deal is a single chance action d in [0,6), player 0 holding
+ card d/2 and player 1 one of the other two, followed by the betting
+ actions pass (0) and bet (1), which double as fold and call. The key of an
+ information set packs the card of the player to act, the number of
+ betting actions and the betting actions themselves.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class KuhnPoker final : public ExtensiveGame{
+    
+public:
+    
+    enum Action{pass,bet};
+    
+    int num_players() const override{
+        return 2;
+    }
+    
+    bool is_terminal(const State & s) const override{
+        int n=s.length-1; // betting actions
+        return n==3||(n==2&&!(s.action(1)==pass&&s.action(2)==bet));
+    }
+    
+    int player(const State & s) const override{
+        return s.length==0 ? chance : (s.length-1)%2;
+    }
+    
+    int num_actions(const State & s) const override{
+        return s.length==0 ? deals : 2;
+    }
+    
+    double chance_probability(const State &, int) const override{
+        return 1.0/deals;
+    }
+    
+    double utility(const State & s, int p) const override{
+        int last=s.action(s.length-1);
+        double u0;
+        if(s.length==3&&s.action(1)==pass&&last==pass) // showdown after two passes
+            u0=card(s,0)>card(s,1) ? 1 : -1;
+        else if(last==pass) // fold: the player who folded loses the ante
+            u0=(s.length-2)%2==0 ? -1 : 1;
+        else // call
+            u0=card(s,0)>card(s,1) ? 2 : -2;
+        return p==0 ? u0 : -u0;
+    }
+    
+    InfosetKey infoset_key(const State & s) const override{
+        InfosetKey betting=s.history>>action_bits;
+        return card(s,player(s))|((InfosetKey) (s.length-1)<<2)|(betting<<4);
+    }
+    
+    string infoset_name(InfosetKey key) const override{
+        string name(1,"JQK"[key&3]);
+        int n=(key>>2)&3;
+        for(int i=0;i<n;++i)
+            name+=(key>>(4+action_bits*i))&1 ? 'b' : 'p';
+        return name;
+    }
+    
+    string action_name(InfosetKey, int a) const override{
+        return a==pass ? "pass" : "bet";
+    }
+    
+    // Card (0 Jack, 1 Queen, 2 King) of player p.
+    static int card(const State & s, int p){
+        int d=s.action(0);
+        int c0=d/2;
+        if(p==0)
+            return c0;
+        // the other two cards, in order
+        return d%2==0 ? (c0==0 ? 1 : 0) : (c0==2 ? 1 : 2);
+    }
+    
+private:
+    
+    static const int deals=6;
+    
+};
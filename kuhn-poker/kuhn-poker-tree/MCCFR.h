@@ -0,0 +1,241 @@
+/********************************************************************************
+ 
+ Monte Carlo CFR on a two-player ExtensiveGame, walking the game itself
+ instead of a prebuilt tree, so that an iteration visits a sampled part of
+ the tree only.
+ 
+ Each iteration runs one traversal for each player, the traverser, which
+ updates the regrets of its own information sets:
+ 
+ - External sampling samples the actions of chance and of the other player
+   (from its current strategy) and tries all the actions of the traverser.
+   The sampling probabilities are the reach probabilities of chance and of
+   the other player, so the sampled counterfactual values need no weights;
+   the other player adds its current strategy to its strategy sums where it
+   is sampled.
+ - Outcome sampling samples a single terminal history z: the traverser
+   plays its current strategy mixed with epsilon of uniform exploration.
+   The utility is divided by the probability q of sampling z, and the
+   regret of action b at a history h of the traverser is increased by u/q
+   times the reach of the other player and chance times pi(z|ha)-pi(z|h)
+   if b is the sampled action a, -pi(z|h) otherwise, where pi(z|.) is the
+   probability that all players and chance then play to z. The strategy
+   sums of the traverser are increased by its strategy weighted by its
+   reach divided by the probability of sampling h (stochastically-weighted
+   averaging).
+ 
+ The current strategies are computed by regret matching when a node is
+ visited, into an array on the stack: the strategy blocks of the arena are
+ left uniform and unused, but are kept so that a copy of the arena has the
+ offsets of the InfosetStore (they add a third to the copies, and are
+ skipped by the reduction). The information sets are numbered once by
+ InfosetStore, whose map from keys to ids is the only lookup of a
+ traversal.
+ 
+ The iterations of a batch are split in one chunk per thread, as in
+ NormalFormCFR.h: each thread has its own generator, drawn from the run
+ seed, and its own copy of the arena, starting from the shared regrets. At
+ the end of the batch the regret changes of the threads, each an estimate
+ of the change of the batch, are averaged (adding them would multiply the
+ step of regret matching by the number of threads and make later batches
+ diverge), and their strategy sums are added, both in thread order, so
+ that a run is reproducible for a given seed and thread count.
+ 
+ Link to paper: http://mlanctot.info/files/papers/nips09mccfr.pdf
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+template<class G>
+class MCCFR{
+    
+public:
+    
+    typedef ExtensiveGame::State State;
+    
+    enum class Sampling { external, outcome };
+    
+    MCCFR(const G & g, unsigned long long Seed) : game(g){
+        seed=Seed;
+        batch=0;
+        iteration=0;
+        sampling=Sampling::external;
+        epsilon=0.6;
+        store.add_infosets(game);
+        store.allocate();
+    }
+    
+    void set_sampling(Sampling s){
+        sampling=s;
+    }
+    
+    // Exploration of outcome sampling.
+    void set_epsilon(double e){
+        epsilon=e;
+    }
+    
+    // Run one batch of "iterations" iterations on "threads" threads.
+    void train(long long iterations, int threads){
+        vector<double> & shared=store.get_arena();
+        vector<vector<double>> arenas(threads);
+        int t;
+        #pragma omp parallel for private(t) schedule(static,1)
+        for(t=0;t<threads;++t){
+            vector<double> & arena=arenas[t];
+            arena=shared;
+            Rng rng(seed,((unsigned long long) (batch+1)<<32)|t);
+            long long chunk=iterations/threads+(t<iterations%threads ? 1 : 0);
+            double tail;
+            for(long long i=0;i<chunk;++i)
+                for(int p=0;p<2;++p){
+                    if(sampling==Sampling::external)
+                        external(game.root(),p,arena.data(),rng);
+                    else
+                        outcome(game.root(),p,1,1,1,arena.data(),rng,tail);
+                }
+        }
+        // reduction in thread order: mean of the regret changes, sum of the
+        // strategy sums
+        for(int id=0;id<store.size();++id){
+            int n=store.actions(id);
+            long long o=store.offset(id);
+            for(int a=0;a<n;++a){
+                double change=0, sum=0;
+                for(t=0;t<threads;++t){
+                    change+=arenas[t][o+a]-shared[o+a];
+                    sum+=arenas[t][o+2*n+a]-shared[o+2*n+a];
+                }
+                shared[o+a]+=change/threads;
+                shared[o+2*n+a]+=sum;
+            }
+        }
+        iteration+=iterations;
+        ++batch;
+    }
+    
+    // Average strategy of every information set.
+    Policy average_policy() const{
+        return store.average_policy();
+    }
+    
+    const InfosetStore & get_store() const{
+        return store;
+    }
+    
+    size_t memory_bytes() const{
+        return store.memory_bytes();
+    }
+    
+    long long get_iteration() const{
+        return iteration;
+    }
+    
+private:
+    
+    // Value for the traverser p at history s; its regrets are updated.
+    double external(const State & s, int p, double * arena, Rng & rng){
+        if(game.is_terminal(s))
+            return game.utility(s,p);
+        int n=game.num_actions(s);
+        int q=game.player(s);
+        if(q==ExtensiveGame::chance)
+            return external(s.next(sample_chance(s,n,rng)),p,arena,rng);
+        int id=store.find(game.infoset_key(s));
+        double * regret_sum=arena+store.offset(id);
+        double * strategy_sum=regret_sum+2*n;
+        array<double,ExtensiveGame::max_actions> strategy;
+        regret_matching(regret_sum,strategy.data(),n);
+        if(q!=p){
+            for(int a=0;a<n;++a)
+                strategy_sum[a]+=strategy[a];
+            return external(s.next(sample(strategy.data(),n,rng)),p,arena,rng);
+        }
+        array<double,ExtensiveGame::max_actions> values;
+        double value=0;
+        for(int a=0;a<n;++a){
+            values[a]=external(s.next(a),p,arena,rng);
+            value+=strategy[a]*values[a];
+        }
+        for(int a=0;a<n;++a)
+            regret_sum[a]+=values[a]-value;
+        return value;
+    }
+    
+    // Sampled utility of the traverser p divided by the probability of the
+    // sample, with the probability of playing from s to the sampled terminal
+    // history in "tail". reach: probability that p plays to s;
+    // other_reach: probability that the other player and chance play to s;
+    // sample_reach: probability of sampling s.
+    double outcome(const State & s, int p, double reach, double other_reach, double sample_reach, double * arena, Rng & rng, double & tail){
+        if(game.is_terminal(s)){
+            tail=1;
+            return game.utility(s,p)/sample_reach;
+        }
+        int n=game.num_actions(s);
+        int q=game.player(s);
+        if(q==ExtensiveGame::chance){
+            int a=sample_chance(s,n,rng);
+            double probability=game.chance_probability(s,a);
+            double u=outcome(s.next(a),p,reach,other_reach*probability,sample_reach*probability,arena,rng,tail);
+            tail*=probability;
+            return u;
+        }
+        int id=store.find(game.infoset_key(s));
+        double * regret_sum=arena+store.offset(id);
+        double * strategy_sum=regret_sum+2*n;
+        array<double,ExtensiveGame::max_actions> strategy;
+        regret_matching(regret_sum,strategy.data(),n);
+        if(q!=p){
+            int a=sample(strategy.data(),n,rng);
+            double u=outcome(s.next(a),p,reach,other_reach*strategy[a],sample_reach*strategy[a],arena,rng,tail);
+            tail*=strategy[a];
+            return u;
+        }
+        // the traverser explores
+        array<double,ExtensiveGame::max_actions> sampling_strategy;
+        for(int b=0;b<n;++b)
+            sampling_strategy[b]=epsilon/n+(1-epsilon)*strategy[b];
+        int a=sample(sampling_strategy.data(),n,rng);
+        double child_tail;
+        double u=outcome(s.next(a),p,reach*strategy[a],other_reach,sample_reach*sampling_strategy[a],arena,rng,child_tail);
+        double w=u*other_reach;
+        for(int b=0;b<n;++b)
+            regret_sum[b]+=b==a ? w*child_tail*(1-strategy[a]) : -w*child_tail*strategy[a];
+        for(int b=0;b<n;++b)
+            strategy_sum[b]+=reach/sample_reach*strategy[b];
+        tail=child_tail*strategy[a];
+        return u;
+    }
+    
+    int sample_chance(const State & s, int n, Rng & rng){
+        double r=rng.uniform();
+        double cumulative=0;
+        for(int a=0;a+1<n;++a){
+            cumulative+=game.chance_probability(s,a);
+            if(r<cumulative)
+                return a;
+        }
+        return n-1;
+    }
+    
+    static int sample(const double * strategy, int n, Rng & rng){
+        double r=rng.uniform();
+        double cumulative=0;
+        for(int a=0;a+1<n;++a){
+            cumulative+=strategy[a];
+            if(r<cumulative)
+                return a;
+        }
+        return n-1;
+    }
+    
+    const G & game;
+    unsigned long long seed;
+    int batch;
+    long long iteration; // iterations so far
+    Sampling sampling;
+    double epsilon;
+    InfosetStore store; // information sets
+    
+};
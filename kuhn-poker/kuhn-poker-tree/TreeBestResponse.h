@@ -0,0 +1,136 @@
+/********************************************************************************
+ 
+ Value of a policy and of best responses to it in a two-player
+ ExtensiveGame, to measure how far CFR is from an equilibrium.
+ 
+ The best response of player p is built from the deepest information sets
+ of p up: every history of an information set is collected with the
+ probability that the other player and chance reach it, and the action
+ chosen is the one with the largest sum of values weighted by those
+ probabilities, the deeper choices being already fixed. With perfect
+ recall, processing the information sets by decreasing length of their
+ shortest history puts every information set after those below it. The
+ values below an information set are recomputed for each of its actions,
+ which is fine for small games like Kuhn poker.
+ 
+ Information sets missing from the policy play uniformly.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+template<class G>
+class TreeBestResponse{
+    
+public:
+    
+    typedef ExtensiveGame::State State;
+    typedef ExtensiveGame::InfosetKey InfosetKey;
+    
+    TreeBestResponse(const G & g, const Policy & p) : game(g), policy(p){
+        responder=none;
+    }
+    
+    // Value of player p when both players follow the policy.
+    double policy_value(int p){
+        responder=none;
+        return value(game.root(),p);
+    }
+    
+    // Value of the best response of player p to the policy of the other.
+    double best_response_value(int p){
+        responder=p;
+        best_actions.clear();
+        infosets.clear();
+        collect(game.root(),1);
+        vector<pair<int,InfosetKey>> order; // (shortest history, key)
+        for(auto & entry : infosets){
+            int shortest=entry.second[0].first.length;
+            for(auto & h : entry.second)
+                shortest=min(shortest,h.first.length);
+            order.push_back({shortest,entry.first});
+        }
+        sort(order.rbegin(),order.rend());
+        for(auto & o : order){
+            vector<pair<State,double>> & histories=infosets[o.second];
+            int n=game.num_actions(histories[0].first);
+            int best=0;
+            double best_value=0;
+            for(int a=0;a<n;++a){
+                double v=0;
+                for(auto & h : histories)
+                    v+=h.second*value(h.first.next(a),p);
+                if(a==0||v>best_value){
+                    best=a;
+                    best_value=v;
+                }
+            }
+            best_actions[o.second]=best;
+        }
+        return value(game.root(),p);
+    }
+    
+    // Sum over the players of what each gains with a best response: zero at
+    // a Nash equilibrium.
+    double nash_conv(){
+        double total=0;
+        for(int p=0;p<2;++p)
+            total+=best_response_value(p)-policy_value(p);
+        return total;
+    }
+    
+private:
+    
+    // Probability of action a at history s under the policy.
+    double probability(const State & s, int a){
+        auto found=policy.find(game.infoset_key(s));
+        if(found==policy.end())
+            return 1.0/game.num_actions(s);
+        return found->second[a];
+    }
+    
+    // Value of player p at history s, the responder playing its best
+    // actions and the other player the policy.
+    double value(const State & s, int p){
+        if(game.is_terminal(s))
+            return game.utility(s,p);
+        int n=game.num_actions(s);
+        int q=game.player(s);
+        if(q==responder)
+            return value(s.next(best_actions[game.infoset_key(s)]),p);
+        double v=0;
+        for(int a=0;a<n;++a){
+            double pr=q==ExtensiveGame::chance ? game.chance_probability(s,a) : probability(s,a);
+            if(pr>0)
+                v+=pr*value(s.next(a),p);
+        }
+        return v;
+    }
+    
+    // Records the histories of the responder with the probability that the
+    // other player and chance reach them.
+    void collect(const State & s, double reach){
+        if(game.is_terminal(s))
+            return;
+        int n=game.num_actions(s);
+        int q=game.player(s);
+        if(q==responder)
+            infosets[game.infoset_key(s)].push_back({s,reach});
+        for(int a=0;a<n;++a){
+            double pr=1;
+            if(q==ExtensiveGame::chance)
+                pr=game.chance_probability(s,a);
+            else if(q!=responder)
+                pr=probability(s,a);
+            collect(s.next(a),reach*pr);
+        }
+    }
+    
+    const G & game;
+    const Policy & policy;
+    static const int none=-2; // not a player, nor chance
+    int responder; // player playing the best response, or none
+    unordered_map<InfosetKey,int> best_actions;
+    map<InfosetKey,vector<pair<State,double>>> infosets;
+    
+};
@@ -0,0 +1,199 @@
+/********************************************************************************
+ 
+ CFR on an extensive-form game (ExtensiveGame.h), here the actual
+ three-card Kuhn poker (KuhnPoker.h): trains by batches of iterations,
+ either full tree walks (CFR.h) or Monte Carlo CFR with external or outcome
+ sampling on several threads (MCCFR.h), prints after each batch the value
+ of the average strategies for player 0, to be compared with the value of
+ the game, -1/18, and their Nash gap (TreeBestResponse.h), and writes a
+ JSON summary of the run with the average strategy of every information
+ set.
+ 
+ Example: kuhn_tree --algorithm external --threads 4 --iterations 100000 --batches 10
+ Run with --help for the list of settings.
+ 
+ ********************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <fstream>
+#include <unordered_map>
+#include <cmath>
+#include <cerrno>
+#include <climits>
+#include <omp.h>
+#include "Rng.h"
+#include "Config.h"
+#include "Profiler.h"
+#include "ExtensiveGame.h"
+#include "KuhnPoker.h"
+#include "InfosetStore.h"
+#include "GameTree.h"
+#include "CFR.h"
+#include "MCCFR.h"
+#include "TreeBestResponse.h"
+
+using namespace std;
+
+const double game_value=-1.0/18;
+const char * algorithm_names[]={"cfr","external","outcome"};
+
+// Information sets sorted by name, for printing.
+vector<pair<string,ExtensiveGame::InfosetKey>> sorted_infosets(const KuhnPoker & game, const Policy & policy){
+    vector<pair<string,ExtensiveGame::InfosetKey>> infosets;
+    for(auto & entry : policy)
+        infosets.push_back({game.infoset_name(entry.first),entry.first});
+    sort(infosets.begin(),infosets.end(),[](const pair<string,ExtensiveGame::InfosetKey> & a, const pair<string,ExtensiveGame::InfosetKey> & b){
+        return a.first.size()!=b.first.size() ? a.first.size()<b.first.size() : a.first<b.first;
+    });
+    return infosets;
+}
+
+// Machine-readable summary of a run: settings, timing, convergence and
+// average strategies.
+template<class Solver>
+bool write_summary(const string & file, Config & config, const KuhnPoker & game, Solver & solver, int threads, double wall_seconds, const vector<double> & values, const vector<double> & nash_conv, Profiler & profiler){
+    ofstream os(file);
+    os.precision(10);
+    os << "{" << endl;
+    os << "  \"program\": \"kuhn_tree\"," << endl;
+    os << "  \"game\": \"kuhn\"," << endl;
+    os << "  \"algorithm\": \"" << config.get_string("algorithm") << "\"," << endl;
+    os << "  \"seed\": " << config.get_int("seed") << "," << endl;
+    os << "  \"threads\": " << threads << "," << endl;
+    os << "  \"iterations\": " << solver.get_iteration() << "," << endl;
+    os << "  \"infosets\": " << solver.get_store().size() << "," << endl;
+    os << "  \"memory_bytes\": " << solver.memory_bytes() << "," << endl;
+    os << "  \"wall_seconds\": " << wall_seconds << "," << endl;
+    double train_seconds=profiler.seconds(0);
+    os << "  \"iterations_per_second\": " << (train_seconds>0 ? solver.get_iteration()/train_seconds : 0) << "," << endl;
+    os << "  \"game_value\": " << game_value << "," << endl;
+    os << "  \"values\": [";
+    for(size_t i=0;i<values.size();++i)
+        os << (i>0 ? ", " : "") << values[i];
+    os << "]," << endl;
+    os << "  \"nash_conv\": [";
+    for(size_t i=0;i<nash_conv.size();++i)
+        os << (i>0 ? ", " : "") << nash_conv[i];
+    os << "]," << endl;
+    os << "  \"strategies\": {";
+    Policy policy=solver.average_policy();
+    vector<pair<string,ExtensiveGame::InfosetKey>> infosets=sorted_infosets(game,policy);
+    for(size_t i=0;i<infosets.size();++i){
+        const vector<double> & s=policy[infosets[i].second];
+        os << (i>0 ? ", " : "") << "\"" << infosets[i].first << "\": [";
+        for(size_t a=0;a<s.size();++a)
+            os << (a>0 ? ", " : "") << s[a];
+        os << "]";
+    }
+    os << "}," << endl;
+    os << "  \"profile\": ";
+    profiler.write_json(os,"  ");
+    os << endl << "}" << endl;
+    os.close();
+    if(!os){
+        cout << "Could not write " << file << endl;
+        return false;
+    }
+    return true;
+}
+
+// Full tree walks run on one thread (main rejects --threads with cfr).
+void train(CFR<KuhnPoker> & cfr, long long iterations, int){
+    cfr.train(iterations);
+}
+
+void train(MCCFR<KuhnPoker> & mccfr, long long iterations, int threads){
+    mccfr.train(iterations,threads);
+}
+
+// Trains by batches with "solver"; returns the exit code of the program.
+template<class Solver>
+int run(Config & config, const KuhnPoker & game, Solver & solver, int threads){
+    long long iterations=config.get_int("iterations");
+    int batches=config.get_int("batches");
+    cout << solver.get_store().size() << " information sets, " << solver.memory_bytes() << " bytes" << endl;
+    Profiler profiler({"train","best_response"});
+    vector<double> values, nash_conv;
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+    for(int b=0;b<batches;++b){
+        {
+            Profiler::Timer timer(profiler,0,0,iterations);
+            train(solver,iterations,threads);
+        }
+        Profiler::Timer timer(profiler,0,1);
+        Policy policy=solver.average_policy();
+        TreeBestResponse<KuhnPoker> best_response(game,policy);
+        values.push_back(best_response.policy_value(0));
+        nash_conv.push_back(best_response.nash_conv());
+        cout << "Batch " << b+1 << ": value " << values.back() << " (game value " << game_value << "), Nash gap " << nash_conv.back() << endl;
+    }
+    double wall_seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    
+    Policy policy=solver.average_policy();
+    cout << "Average strategies (pass, bet):" << endl;
+    for(auto & infoset : sorted_infosets(game,policy)){
+        const vector<double> & s=policy[infoset.second];
+        cout << "  " << infoset.first << ":";
+        for(double p : s)
+            cout << " " << p;
+        cout << endl;
+    }
+    cout << "Program Execution Time: " << wall_seconds*1000 << " ms" << endl;
+    string summary=config.get_string("summary");
+    if(!write_summary(summary,config,game,solver,threads,wall_seconds,values,nash_conv,profiler))
+        return 1;
+    cout << "Summary written to " << summary << endl;
+    return 0;
+}
+
+int main(int argc, char ** argv){
+    
+    Config config;
+    config.add("algorithm",Config::Kind::text,"cfr","cfr (full tree walks), external or outcome (Monte Carlo CFR sampling)");
+    config.add("threads",Config::Kind::integer,to_string(omp_get_max_threads()),"number of OpenMP threads (external and outcome)");
+    config.set_range("threads",1,INT_MAX);
+    config.add("iterations",Config::Kind::integer,"10000","iterations per batch");
+    config.set_range("iterations",0,LLONG_MAX);
+    config.add("batches",Config::Kind::integer,"10","batches; the value and Nash gap are computed after each");
+    config.set_range("batches",0,INT_MAX);
+    config.add("seed",Config::Kind::integer,to_string(time(0)),"seed of the run (default: the time)");
+    config.add("epsilon",Config::Kind::real,"0.6","exploration of outcome sampling");
+    config.add("summary",Config::Kind::text,"summary.json","JSON summary file");
+    if(!config.parse(argc,argv))
+        return 1;
+    string algorithm=config.get_string("algorithm");
+    int thread_count=config.get_int("threads");
+    omp_set_num_threads(thread_count);
+    
+    KuhnPoker game;
+    if(algorithm==algorithm_names[0]){
+        if(config.has("threads")&&thread_count>1){
+            cout << "The cfr algorithm runs on one thread, --threads is for external and outcome" << endl;
+            return 1;
+        }
+        CFR<KuhnPoker> cfr(game);
+        cout << "Tree of " << cfr.get_tree().size() << " nodes" << endl;
+        return run(config,game,cfr,1);
+    }
+    if(algorithm==algorithm_names[1]||algorithm==algorithm_names[2]){
+        cout << "Seed: " << config.get_int("seed") << endl;
+        MCCFR<KuhnPoker> mccfr(game,config.get_int("seed"));
+        if(algorithm==algorithm_names[2])
+            mccfr.set_sampling(MCCFR<KuhnPoker>::Sampling::outcome);
+        mccfr.set_epsilon(config.get_double("epsilon"));
+        return run(config,game,mccfr,thread_count);
+    }
+    cout << "Invalid value \"" << algorithm << "\" for algorithm, expected one of";
+    for(const char * name : algorithm_names)
+        cout << " " << name;
+    cout << endl;
+    return 1;
+}
@@ -0,0 +1,186 @@
+/********************************************************************************
+ 
+ Regret matching for all the players of a NormalFormGame, in parallel.
+ 
+ Every iteration, each player draws an action from the strategy given by
+ its regrets, and then adds to its regrets the utilities of all its actions
+ against the actions drawn by the others (one contiguous row of its payoff
+ table), minus the utility of the action it played. The average strategies
+ converge to a coarse correlated equilibrium, and to a Nash equilibrium in
+ two-player zero-sum games.
+ 
+ In the expected mode nothing is sampled: every iteration, each player adds
+ to its regrets the expected utilities of all its actions against the
+ current strategies of the others, computed as one matrix-vector product
+ (UtilityKernels.h), minus the expected utility of its own strategy. Each
+ iteration costs a pass over the payoff tables but removes the sampling
+ noise, so far fewer iterations are needed; the threads share the products.
+ With CFR+ the regrets are floored at zero and iteration t weighs t in the
+ average strategy.
+ 
+ The iterations of a batch are split in one chunk per thread, as in
+ parallel_cfr_rps.cpp: each thread has its own generator, drawn from the run
+ seed, and its own regret and strategy sums, starting from the shared
+ regrets. At the end of a batch in the sampled mode, the regret changes of
+ the threads, each an estimate of the change of the batch, are averaged
+ (adding them would multiply the step of regret matching by the number of
+ threads and make later batches diverge), and their strategy sums are
+ added, both in thread order, so that a run is reproducible for a given
+ seed and thread count. T is the type of the sums (float or double).
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+template<class T>
+class NormalFormCFR{
+    
+public:
+    
+    enum class Mode { sampled, expected };
+    
+    // cfrPlus is used in the expected mode only.
+    enum class UpdateRule { vanilla, cfrPlus };
+    
+    NormalFormCFR(NormalFormGame & g, unsigned long long Seed) : game(g){
+        seed=Seed;
+        batch=0;
+        iteration=0;
+        mode=Mode::sampled;
+        updateRule=UpdateRule::vanilla;
+        int n=game.players();
+        regretSums.resize(n);
+        strategySums.resize(n);
+        for(int p=0;p<n;++p){
+            regretSums[p].assign(game.actions(p),0);
+            strategySums[p].assign(game.actions(p),0);
+        }
+    }
+    
+    // Run one batch of "iterations" iterations on "threads" threads.
+    void train(long long iterations, int threads){
+        if(mode==Mode::expected)
+            trainExpected(iterations,threads);
+        else
+            trainSampled(iterations,threads);
+        ++batch;
+    }
+    
+    void trainSampled(long long iterations, int threads){
+        int n=game.players();
+        vector<Accumulator> accumulators(threads);
+        int t;
+        #pragma omp parallel for private(t) schedule(static,1)
+        for(t=0;t<threads;++t){
+            Accumulator & acc=accumulators[t];
+            acc.regretSums=regretSums;
+            acc.strategySums.resize(n);
+            vector<vector<T>> strategies(n);
+            for(int p=0;p<n;++p){
+                acc.strategySums[p].assign(game.actions(p),0);
+                strategies[p].resize(game.actions(p));
+            }
+            vector<int> profile(n);
+            Rng rng(seed,((unsigned long long) (batch+1)<<32)|t);
+            long long chunk=iterations/threads+(t<iterations%threads ? 1 : 0);
+            for(long long i=0;i<chunk;++i){
+                for(int p=0;p<n;++p){
+                    getStrategy(acc.regretSums[p].data(),strategies[p].data(),acc.strategySums[p].data(),game.actions(p));
+                    profile[p]=getAction(strategies[p].data(),game.actions(p),rng);
+                }
+                for(int p=0;p<n;++p){
+                    const float * utilities=game.table(p)+game.offset(p,profile.data());
+                    addRegrets(acc.regretSums[p].data(),utilities,(T) utilities[profile[p]],game.actions(p));
+                }
+            }
+        }
+        // reduction in thread order: mean of the regret changes, sum of the
+        // strategy sums
+        for(int p=0;p<n;++p)
+            for(int a=0;a<game.actions(p);++a){
+                T change=0;
+                for(t=0;t<threads;++t){
+                    change+=accumulators[t].regretSums[p][a]-regretSums[p][a];
+                    strategySums[p][a]+=accumulators[t].strategySums[p][a];
+                }
+                regretSums[p][a]+=change/threads;
+            }
+        iteration+=iterations;
+    }
+    
+    void trainExpected(long long iterations, int threads){
+        int n=game.players();
+        vector<vector<T>> strategies(n), utilities(n);
+        for(int p=0;p<n;++p){
+            strategies[p].resize(game.actions(p));
+            utilities[p].resize(game.actions(p));
+        }
+        for(long long i=0;i<iterations;++i){
+            ++iteration;
+            for(int p=0;p<n;++p){
+                regretMatching(regretSums[p].data(),strategies[p].data(),game.actions(p));
+                // linear averaging of CFR+
+                T weight=updateRule==UpdateRule::cfrPlus ? (T) iteration : 1;
+                for(int a=0;a<game.actions(p);++a)
+                    strategySums[p][a]+=weight*strategies[p][a];
+            }
+            for(int p=0;p<n;++p)
+                game.expectedUtilities(p,strategies,utilities[p].data(),threads);
+            for(int p=0;p<n;++p){
+                T value=0;
+                for(int a=0;a<game.actions(p);++a)
+                    value+=strategies[p][a]*utilities[p][a];
+                addRegrets(regretSums[p].data(),utilities[p].data(),value,game.actions(p));
+                if(updateRule==UpdateRule::cfrPlus)
+                    for(int a=0;a<game.actions(p);++a)
+                        regretSums[p][a]=max(regretSums[p][a],(T) 0);
+            }
+        }
+    }
+    
+    void setMode(Mode m){
+        mode=m;
+    }
+    
+    void setUpdateRule(UpdateRule r){
+        updateRule=r;
+    }
+    
+    // Average strategy of every player.
+    vector<vector<double>> averageStrategies(){
+        vector<vector<double>> average(game.players());
+        for(int p=0;p<game.players();++p){
+            vector<double> sums(strategySums[p].begin(),strategySums[p].end());
+            average[p].resize(sums.size());
+            averageStrategy(sums.data(),average[p].data(),sums.size());
+        }
+        return average;
+    }
+    
+    // Nash gap of the average strategies.
+    double nashConv(int threads=1){
+        return game.nashConv(averageStrategies(),threads);
+    }
+    
+    int getBatch(){
+        return batch;
+    }
+    
+private:
+    
+    // Sums of one thread.
+    struct Accumulator{
+        vector<vector<T>> regretSums;
+        vector<vector<T>> strategySums;
+    };
+    
+    NormalFormGame & game;
+    unsigned long long seed;
+    int batch;
+    long long iteration; // iterations so far
+    Mode mode;
+    UpdateRule updateRule;
+    vector<vector<T>> regretSums;
+    vector<vector<T>> strategySums;
+    
+};
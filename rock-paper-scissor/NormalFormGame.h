@@ -0,0 +1,210 @@
+/********************************************************************************
+ 
+ A finite normal-form game: any number of players, each with its own number
+ of actions, and the payoff of every player for every profile of actions,
+ loaded from a text file.
+ 
+ File format ("#" starts a comment, numbers are separated by white space):
+ 
+   players 2
+   actions 3 3
+   payoffs
+   0 0   -1 1   1 -1
+   ...
+ 
+ After "payoffs" come the profiles in lexicographic order (the action of the
+ last player changes fastest), and for every profile the payoff of each
+ player in turn. games/ has examples.
+ 
+ The payoffs of every player are stored in a table of their own, in which
+ the action of that player changes fastest: the utilities of all the
+ actions of a player against a profile of the other players are contiguous,
+ so that the training loop reads them as one vector, and the table is a
+ matrix with one row per profile of the other players.
+ 
+ ********************************************************************************/
+
+using namespace std;
+
+class NormalFormGame{
+    
+public:
+    
+    // Read the game in "file". Returns false, after printing why, if the
+    // file cannot be read or is not a valid game.
+    bool load(const string & file){
+        ifstream is(file);
+        if(!is){
+            cout << "Cannot open game file " << file << endl;
+            return false;
+        }
+        // the file without its comments
+        stringstream content;
+        string line;
+        while(getline(is,line))
+            content << line.substr(0,line.find('#')) << "\n";
+        string word;
+        int n=0;
+        if(!(content >> word)||word!="players"||!(content >> n)||n<1){
+            cout << file << ": expected \"players <number>\"" << endl;
+            return false;
+        }
+        vector<int> a(n);
+        if(!(content >> word)||word!="actions"){
+            cout << file << ": expected \"actions\" and the number of actions of each player" << endl;
+            return false;
+        }
+        long long size=1;
+        for(int p=0;p<n;++p){
+            if(!(content >> a[p])||a[p]<1){
+                cout << file << ": invalid number of actions of player " << p << endl;
+                return false;
+            }
+            size*=a[p];
+            if(size*n>maxPayoffs){
+                cout << file << ": the game has more than " << maxPayoffs << " payoffs" << endl;
+                return false;
+            }
+        }
+        if(!(content >> word)||word!="payoffs"){
+            cout << file << ": expected \"payoffs\"" << endl;
+            return false;
+        }
+        vector<float> payoffs(size*n);
+        for(long long i=0;i<size*n;++i){
+            if(!(content >> payoffs[i])){
+                cout << file << ": expected " << size*n << " payoffs, found " << i << endl;
+                return false;
+            }
+        }
+        if(content >> word){
+            cout << file << ": unexpected \"" << word << "\" after the payoffs" << endl;
+            return false;
+        }
+        setGame(a,payoffs);
+        return true;
+    }
+    
+    // "payoffs" lists the profiles in lexicographic order, with the payoff
+    // of every player for each profile, as in a game file.
+    void setGame(const vector<int> & a, const vector<float> & payoffs){
+        actionCounts=a;
+        int n=a.size();
+        profileCount=1;
+        for(int p=0;p<n;++p)
+            profileCount*=a[p];
+        // strides[p][q]: step in the table of player p for one more action of player q
+        strides.assign(n,vector<long long>(n));
+        for(int p=0;p<n;++p){
+            long long stride=a[p];
+            for(int q=n-1;q>=0;--q){
+                if(q==p)
+                    continue;
+                strides[p][q]=stride;
+                stride*=a[q];
+            }
+            strides[p][p]=1;
+        }
+        tables.assign(n,vector<float>(profileCount));
+        vector<int> profile(n,0);
+        for(long long i=0;i<profileCount;++i){
+            for(int p=0;p<n;++p)
+                tables[p][offset(p,profile.data())+profile[p]]=payoffs[i*n+p];
+            nextProfile(profile,-1);
+        }
+    }
+    
+    int players(){
+        return actionCounts.size();
+    }
+    
+    int actions(int p){
+        return actionCounts[p];
+    }
+    
+    long long profiles(){
+        return profileCount;
+    }
+    
+    // Position in table(p) of the utilities of all the actions of player p
+    // when the others play "profile" (the action of p in it is ignored).
+    long long offset(int p, const int * profile){
+        long long o=0;
+        for(int q=0;q<players();++q)
+            if(q!=p)
+                o+=profile[q]*strides[p][q];
+        return o;
+    }
+    
+    const float * table(int p){
+        return tables[p].data();
+    }
+    
+    float payoff(int p, const int * profile){
+        return tables[p][offset(p,profile)+profile[p]];
+    }
+    
+    // Expected utility of every action of player p when each other player q
+    // plays the mixed strategy strategies[q]: the rows of table(p), one per
+    // profile of the other players, weighted by the probabilities of the
+    // profiles (UtilityKernels.h).
+    template<class T>
+    void expectedUtilities(int p, const vector<vector<T>> & strategies, T * utilities, int threads=1){
+        int n=actions(p);
+        long long rows=profileCount/n;
+        if(players()==2){
+            weightedRowSum(table(p),rows,n,strategies[1-p].data(),utilities,threads);
+            return;
+        }
+        vector<T> weights(rows);
+        vector<int> profile(players(),0);
+        for(long long o=0;o<rows;++o){
+            T w=1;
+            for(int q=0;q<players();++q)
+                if(q!=p)
+                    w*=strategies[q][profile[q]];
+            weights[o]=w;
+            nextProfile(profile,p);
+        }
+        weightedRowSum(table(p),rows,n,weights.data(),utilities,threads);
+    }
+    
+    // Sum over the players of what each could gain by deviating alone to a
+    // best response: zero at a Nash equilibrium.
+    double nashConv(const vector<vector<double>> & strategies, int threads=1){
+        double total=0;
+        for(int p=0;p<players();++p){
+            vector<double> u(actions(p));
+            expectedUtilities(p,strategies,u.data(),threads);
+            double best=u[0], value=0;
+            for(int a=0;a<actions(p);++a){
+                best=max(best,u[a]);
+                value+=strategies[p][a]*u[a];
+            }
+            total+=best-value;
+        }
+        return total;
+    }
+    
+private:
+    
+    // Next profile in lexicographic order, skipping the actions of player
+    // "fixed" (none if -1).
+    void nextProfile(vector<int> & profile, int fixed){
+        for(int q=players()-1;q>=0;--q){
+            if(q==fixed)
+                continue;
+            if(++profile[q]<actionCounts[q])
+                return;
+            profile[q]=0;
+        }
+    }
+    
+    static constexpr long long maxPayoffs=1LL<<28;
+    
+    vector<int> actionCounts;
+    long long profileCount=0;
+    vector<vector<long long>> strides;
+    vector<vector<float>> tables;
+    
+};
@@ -0,0 +1,96 @@
+/********************************************************************************
+
+ Regret matching kernels for a player with n actions.
+
+ The kernels work on plain arrays of n values, the strategy, regret and
+ strategy sums of a player, kept on the stack or in a per-thread
+ accumulator: they never allocate, are inlined into the training loop, and
+ their loops over the actions have no data-dependent branches, so that the
+ compiler vectorizes them. The array<float,N> overloads, used by the RPS
+ trainers, have a compile-time number of actions and are fully unrolled for
+ small N.
+
+ Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
+ ********************************************************************************/
+
+using namespace std;
+
+// The strategy is proportional to the positive regrets, uniform if there are none
+template<class T>
+inline void regretMatching(const T *regretSum, T *strategy, int n){
+    T normalizingSum = 0;
+    for(int a=0; a<n; a++){
+        strategy[a] = regretSum[a] > 0 ? regretSum[a] : 0;
+        normalizingSum += strategy[a];
+    }
+    T scale = normalizingSum > 0 ? 1 / normalizingSum : 0;
+    T uniform = normalizingSum > 0 ? 0 : T(1) / n;
+    for(int a=0; a<n; a++)
+        strategy[a] = strategy[a] * scale + uniform;
+}
+
+// Regret matching, adding the strategy to the strategy sum
+template<class T>
+inline void getStrategy(const T *regretSum, T *strategy, T *strategySum, int n){
+    regretMatching(regretSum, strategy, n);
+    for(int a=0; a<n; a++)
+        strategySum[a] += strategy[a];
+}
+
+// Returns a random action according to the strategy, drawn from the given generator
+template<class T>
+inline int getAction(const T *strategy, int n, Rng &rng){
+    T r = rng.uniform();
+    T cumulative = 0;
+    for(int a=0; a+1<n; a++){
+        cumulative += strategy[a];
+        if(r < cumulative)
+            return a;
+    }
+    return n-1;
+}
+
+// Adds the regret of not having played each action, given the utilities of
+// all actions against the other players and the utility u of the action played
+template<class T, class U>
+inline void addRegrets(T *regretSum, const U *utilities, T u, int n){
+    for(int a=0; a<n; a++)
+        regretSum[a] += utilities[a] - u;
+}
+
+// The strategy sum normalized to probabilities, uniform if it is zero
+template<class T>
+inline void averageStrategy(const T *strategySum, T *average, int n){
+    T normalizingSum = 0;
+    for(int a=0; a<n; a++)
+        normalizingSum += strategySum[a];
+    for(int a=0; a<n; a++)
+        average[a] = normalizingSum > 0 ? strategySum[a] / normalizingSum : T(1) / n;
+}
+
+template<size_t N>
+inline void regretMatching(const array<float,N> &regretSum, array<float,N> &strategy){
+    regretMatching(regretSum.data(), strategy.data(), N);
+}
+
+template<size_t N>
+inline void getStrategy(const array<float,N> &regretSum, array<float,N> &strategy, array<float,N> &strategySum){
+    getStrategy(regretSum.data(), strategy.data(), strategySum.data(), N);
+}
+
+template<size_t N>
+inline int getAction(const array<float,N> &strategy, Rng &rng){
+    return getAction(strategy.data(), N, rng);
+}
+
+template<size_t N>
+inline void addRegrets(array<float,N> &regretSum, const array<float,N> &utilities, float u){
+    addRegrets(regretSum.data(), utilities.data(), u, N);
+}
+
+template<size_t N>
+inline array<float,N> averageStrategy(const array<float,N> &strategySum){
+    array<float,N> average;
+    averageStrategy(strategySum.data(), average.data(), N);
+    return average;
+}
@@ -0,0 +1,68 @@
+/********************************************************************************
+
+ Expected utilities of all the actions of a player as one matrix-vector
+ product: out[c] = sum over r of weights[r]*table[r*cols+c], where the rows
+ of the payoff table are the profiles of the other players, weighted by
+ their probabilities, and the columns are the actions of the player.
+
+ The kernel is blocked like a BLAS gemv: the columns are processed in
+ blocks whose outputs stay in the L1 cache, four rows at a time, so that
+ each output is loaded and stored once per four rows, and the loop over the
+ columns is a SIMD loop. Large tables are split by rows over the threads,
+ each summing into its own output, and the outputs are added in thread
+ order, so the result does not depend on the scheduling.
+
+ ********************************************************************************/
+
+using namespace std;
+
+// Adds the weighted rows [r0, r1) of the table to out.
+template<class T>
+inline void addWeightedRows(const float *table, long long r0, long long r1, int cols, const T *weights, T *out){
+    const int block = 2048; // columns per block
+    for(int c0 = 0; c0 < cols; c0 += block){
+        int c1 = min(cols, c0 + block);
+        long long r = r0;
+        for(; r + 4 <= r1; r += 4){
+            T w0 = weights[r], w1 = weights[r+1], w2 = weights[r+2], w3 = weights[r+3];
+            if(w0 == 0 && w1 == 0 && w2 == 0 && w3 == 0)
+                continue;
+            const float *t0 = table + r*cols, *t1 = t0 + cols, *t2 = t1 + cols, *t3 = t2 + cols;
+            #pragma omp simd
+            for(int c = c0; c < c1; c++)
+                out[c] += w0*t0[c] + w1*t1[c] + w2*t2[c] + w3*t3[c];
+        }
+        for(; r < r1; r++){
+            T w = weights[r];
+            if(w == 0)
+                continue;
+            const float *t = table + r*cols;
+            #pragma omp simd
+            for(int c = c0; c < c1; c++)
+                out[c] += w*t[c];
+        }
+    }
+}
+
+// out[c] = sum over r of weights[r]*table[r*cols+c], on up to "threads" threads.
+template<class T>
+void weightedRowSum(const float *table, long long rows, int cols, const T *weights, T *out, int threads){
+    fill(out, out + cols, T(0));
+    // below this many payoffs, starting the threads costs more than it saves
+    const long long parallelSize = 1 << 16;
+    if(threads <= 1 || rows*cols < parallelSize){
+        addWeightedRows(table, 0, rows, cols, weights, out);
+        return;
+    }
+    vector<vector<T>> partial(threads);
+    int t;
+    #pragma omp parallel for private(t) schedule(static,1) num_threads(threads)
+    for(t = 0; t < threads; t++){
+        long long r0 = rows*t/threads, r1 = rows*(t+1)/threads;
+        partial[t].assign(cols, T(0));
+        addWeightedRows(table, r0, r1, cols, weights, partial[t].data());
+    }
+    for(t = 0; t < threads; t++)
+        for(int c = 0; c < cols; c++)
+            out[c] += partial[t][c];
+}
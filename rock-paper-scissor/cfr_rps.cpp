@@ -2,189 +2,114 @@
 
 //Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
 
+//Example: rps_serial --rule cfr+ --seed 1 (run with --help for the settings)
+
 #include<bits/stdc++.h>
+#include "Rng.h"
+#include "Config.h"
+#include "RegretMatching.h"
 
 using namespace std;
 
-// Returns the adjusted strategy after an iteration
-vector<vector<float>> getStrategy(vector<float> &regretSum, vector<float> &strategySum){
-    int actions = 3;
-    float normalizingSum =0;
-    vector<float> strategy = {0,0,0};
-    //NormalizingSum is the sum of positive regrets.
-    //This ensures do not 'over-adjust' and coverage to equilibrium
-    for(int i=0; i< actions; i++){
-        if(regretSum[i]> 0)
-            strategy[i] = regretSum[i];
-        else 
-            strategy[i] = 0;
-        normalizingSum += strategy[i];
-    }
-    // This loop normalizes our update strategy
-    for(int i=0; i< actions; i++) {
-        if(normalizingSum > 0)
-            strategy[i] = strategy[i]/normalizingSum;
-        else {
-            // Default to 33%
-            strategy[i] = 1.0 / actions;
-        }
-        strategySum[i] += strategy[i]; 
-    }
-
-    vector<vector<float>> strategyStrategySum;
-    strategyStrategySum.push_back(strategy);
-    strategyStrategySum.push_back(strategySum);
-    return strategyStrategySum;
-}
+// payoff[b][a] is the utility of action a against action b:
+// Rock (0) beats Scissors (2), Paper (1) beats Rock, Scissors beat Paper
+const array<array<float,3>,3> payoff = {{{0, 1, -1}, {-1, 0, 1}, {1, -1, 0}}};
 
 //sum function
 float sum(vector<float> &arraySum){
-    float s=0;
-    for(int i=0;i<arraySum.size();i++){
-        s+=arraySum[i];
-    }
-    return s;
+    return arraySum[0] + arraySum[1] + arraySum[2];
 }
 
-// Returns a random action according to the strategy
-
-int getAction(vector<float> &strategy){
-    float r = (float)rand() / (float)RAND_MAX;
-    if(r>= 0 && r< strategy[0])
-        return 0;
-    else if (r>=strategy[0] && r<(strategy[0]+strategy[1]))
-        return 1;
-    else if (r>=strategy[0] + strategy[1] && r<sum(strategy)) // Using the implemeted sum function
-        return 2;
-    else 
-        return 0;
+array<float,3> toArray(const vector<float> &v){
+    return {v[0], v[1], v[2]};
 }
 
+vector<float> toVector(const array<float,3> &a){
+    return {a[0], a[1], a[2]};
+}
 
-vector<float> train(int iterations, vector<float> &regretSum, vector<float> &oppStrategy) {
-    vector<int> actionUtility = {0,0,0};
-    vector<float> strategySum = {0,0,0};
-    int actions = 3;
+// Trains against a fixed opponent strategy; returns the strategy sum and adds the regrets to regretSum
+vector<float> train(int iterations, vector<float> &regretSum, vector<float> &oppStrategy, Rng &rng) {
+    array<float,3> regrets = toArray(regretSum), strategy, strategySum = {0,0,0};
+    const array<float,3> opp = toArray(oppStrategy);
     for (int i = 0; i< iterations; i++) {
         // Retrieve Actions
-        vector<vector<float>> t = getStrategy(regretSum, strategySum);
-        vector<float> strategy = t[0];
-        vector<float> strategySum = t[1];
-        
-        float myaction = getAction(strategy);
+        getStrategy(regrets, strategy, strategySum);
+        int myAction = getAction(strategy, rng);
         // Define an arbitary opponent strategy from which to adjust
-        float otherAction = getAction(oppStrategy);
-        
-        // Opponent Chooses Scissors
-        if(otherAction == actions-1) {
-            // Utility(Rock) = 1
-            actionUtility[0] = 1;
-            // Utility(Paper) = -1
-            actionUtility[1] = -1;
-        // Opponent Chooses Rock
-        }
-        else if (otherAction == 0) {
-            // Utility(Scissors) = -1
-            actionUtility[actions -1] = -1;
-            // Utility(Paper) = 1
-            actionUtility[1] = 1;
-        // Opponent Chooses Paper
-        }
-        else {
-            // Utility(Rock) = -1
-            actionUtility[0] = -1;
-            // Utility(Scissors) = 1
-            actionUtility[2] = 1;
-        }
-
+        int otherAction = getAction(opp, rng);
         // Add the regrets from this decision
-        for(int i=0; i< actions; i++) {
-            regretSum[i] += actionUtility[i] - actionUtility[myaction];
-        }
+        addRegrets(regrets, payoff[otherAction], payoff[otherAction][myAction]);
     }
-    return strategySum;
+    regretSum = toVector(regrets);
+    return toVector(strategySum);
 }
 
-vector<float> getAverageStrategy(int iterations, vector<float> &oppStrategy) {
-    int actions = 3;
+vector<float> getAverageStrategy(int iterations, vector<float> &oppStrategy, Rng &rng) {
     vector<float> regretSum={0,0,0};
-    vector<float> strategySum= train(iterations, regretSum , oppStrategy);
-    vector<float> avgStrategy= {0,0,0};
-    float normalizingSum = 0;
-    for(int i=0; i<actions; i++){
-        normalizingSum += strategySum[i];
+    vector<float> strategySum= train(iterations, regretSum , oppStrategy, rng);
+    return toVector(averageStrategy(toArray(strategySum)));
+}
+
+
+// Update rules for train2Player, applied at the end of each iteration:
+// vanilla: plain regret matching, every iteration weighs the same in the average strategy
+// cfrPlus: regrets are floored at zero and iteration t weighs t in the average (CFR+)
+// discounted: positive regrets are scaled by t^alpha/(t^alpha+1), negative ones by
+// t^beta/(t^beta+1) and the strategy sum by (t/(t+1))^gamma (Discounted CFR)
+enum class UpdateRule { vanilla, cfrPlus, discounted };
+
+const float dcfrAlpha = 1.5, dcfrBeta = 0, dcfrGamma = 2;
+
+// Applies the update rule to the sums at the end of iteration t (counted from 1)
+void applyUpdateRule(UpdateRule rule, long long t, array<float,3> &regretSum, array<float,3> &strategySum){
+    if(rule == UpdateRule::vanilla)
+        return;
+    // CFR+ floors the regrets, and scaling the sum by t/(t+1) every iteration gives linear weights
+    float positive = 1, negative = 0, average = (float)t/(t+1);
+    if(rule == UpdateRule::discounted){
+        positive = pow(t,dcfrAlpha)/(pow(t,dcfrAlpha)+1);
+        negative = pow(t,dcfrBeta)/(pow(t,dcfrBeta)+1);
+        average = pow((float)t/(t+1),dcfrGamma);
     }
-    for(int i=0; i<actions; i++) {
-        if(normalizingSum > 0) {
-            avgStrategy[i] = strategySum[i] / normalizingSum;
-        }
-        else {
-            avgStrategy[i] = 1.0 / actions;
-        }
+    for(int i=0; i<3; i++){
+        regretSum[i] *= regretSum[i] > 0 ? positive : negative;
+        strategySum[i] *= average;
     }
-    return avgStrategy;
 }
 
-
 // Two player training function
-vector<vector<float>> train2Player(int iterations, vector<float> &regretSum1, vector<float> &regretSum2, vector<float> &p2Strat) {
+vector<vector<float>> train2Player(int iterations, vector<float> &regretSum1, vector<float> &regretSum2, Rng &rng, UpdateRule rule) {
     // Adapt train function for two players
-    int actions = 3;
-    vector<int> actionUtility= {0,0,0};
-    vector<float> strategySum1 = {0,0,0};
-    vector<float> strategySum2 = {0,0,0};
+    array<float,3> regrets1 = toArray(regretSum1), regrets2 = toArray(regretSum2);
+    array<float,3> strategy1, strategy2, strategySum1 = {0,0,0}, strategySum2 = {0,0,0};
     for(int i=0; i< iterations; i++) {
         // Retrieve Actions
-        vector<vector<float>>t1 = getStrategy(regretSum1, strategySum1);
-        vector<float> strategy1 = t1[0];
-        strategySum1 = t1[1];
-        float myaction = getAction(strategy1);
-        vector<vector<float>>t2 = getStrategy(regretSum2, p2Strat);
-        vector<float> strategy2 = t2[0];
-        strategySum2 = t2[1];
-        float otherAction = getAction(strategy2);
-
-        // Opponent Chooses scissors
-        if (otherAction == actions -1) {
-            // Utility(Rock) = 1
-            actionUtility[0] = 1;
-            // Utility(Paper) = -1
-            actionUtility[1] = -1;
-        }
-        // Opponent chooses Rock
-        else if (otherAction == 0) {
-            // Utility(Scissors) = -1
-            actionUtility[actions-1] = -1;
-            // Utility(Paper) = 1
-            actionUtility[1] = 1;
-        }
-        // Opponent Chooses Paper
-        else {
-            // Utility(Rock) = -1
-            actionUtility[0] = -1;
-            // Utility(Scissors) = 1
-            actionUtility[2] = 1;
-        }
-
-        // Add the regrets from this decision 
-        for(int i=0 ; i< actions; i++){
-            regretSum1[i] += actionUtility[i] - actionUtility[myaction];
-            regretSum2[i] += -(actionUtility[i] - actionUtility[myaction]);
-        }
+        getStrategy(regrets1, strategy1, strategySum1);
+        int myAction = getAction(strategy1, rng);
+        getStrategy(regrets2, strategy2, strategySum2);
+        int otherAction = getAction(strategy2, rng);
+        // Add the regrets from this decision
+        addRegrets(regrets1, payoff[otherAction], payoff[otherAction][myAction]);
+        addRegrets(regrets2, payoff[myAction], payoff[myAction][otherAction]);
+        applyUpdateRule(rule, i+1, regrets1, strategySum1);
+        applyUpdateRule(rule, i+1, regrets2, strategySum2);
     }
+    regretSum1 = toVector(regrets1);
+    regretSum2 = toVector(regrets2);
 
     vector<vector<float>> strategySum12;
-    strategySum12.push_back(strategySum1);
-    strategySum12.push_back(strategySum2);
+    strategySum12.push_back(toVector(strategySum1));
+    strategySum12.push_back(toVector(strategySum2));
     return strategySum12;
 }
 
 // Returns the Nash Equilibrium reached by two opponents throught Counterfactual Regret Minimisation:
 
-vector<vector<float>> RPStoNash(int iterations, vector<float> &oppStrat) {
+vector<vector<float>> RPStoNash(int iterations, Rng &rng, UpdateRule rule) {
     vector<float> regretSum1 ={0,0,0};
     vector<float> regretSum2 ={0,0,0};
-    vector<vector<float>> strats = train2Player(iterations, regretSum1, regretSum2, oppStrat);
+    vector<vector<float>> strats = train2Player(iterations, regretSum1, regretSum2, rng, rule);
     
     float s1 = sum(strats[0]);
     float s2 = sum(strats[1]);
@@ -201,7 +126,30 @@ vector<vector<float>> RPStoNash(int iterations, vector<float> &oppStrat) {
     return strats;
 }
 
-int main(){
+const char* ruleNames[] = {"vanilla", "cfr+", "discounted"};
+
+int main(int argc, char** argv){
+
+Config config;
+config.add("seed", Config::Kind::integer, "", "seed of the run (default: the time)");
+config.add("rule", Config::Kind::text, "vanilla", "update rule of the two player training: vanilla, cfr+ or discounted");
+if(!config.parse(argc, argv))
+    return 1;
+
+// update rule of the two player training
+int ruleIndex = -1;
+for(int r=0; r<3; r++)
+    if(config.get_string("rule") == ruleNames[r])
+        ruleIndex = r;
+if(ruleIndex < 0){
+    cout<<"Invalid value \""<<config.get_string("rule")<<"\" for rule, expected one of vanilla cfr+ discounted"<<endl;
+    return 1;
+}
+UpdateRule rule = (UpdateRule)ruleIndex;
+
+unsigned long long seed = config.has("seed") ? config.get_int("seed") : time(0);
+cout<<"Seed: "<<seed<<endl;
+Rng rng(seed);
 
 vector<float> oppStrat = {0.4,0.3,0.3}; clock_t time_req;
 cout<<"Opponent's Strategy: ";
@@ -209,14 +157,14 @@ for(auto itr:oppStrat){
     cout<<itr<<" ";
 }
 time_req = clock();
-vector<float> ans = getAverageStrategy(1000000,oppStrat);
+vector<float> ans = getAverageStrategy(1000000,oppStrat,rng);
 cout<<"\nMaximally Exploitative Strategy: ";
 
 for(auto itr:ans){
     cout<<itr<<" ";
 }
 
-vector<vector<float>> rpsToNash = RPStoNash(1000000,oppStrat);
+vector<vector<float>> rpsToNash = RPStoNash(1000000,rng,rule);
 cout<<"\nNash Equilibrium at: ";
 
 for(auto itr:rpsToNash[0]){
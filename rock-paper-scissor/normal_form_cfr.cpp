@@ -0,0 +1,152 @@
+//Counterfactual Regret Minimization for any normal-form game, generalizing cfr_rps.cpp
+//to any number of players and actions, with the payoffs read from a file (see NormalFormGame.h)
+
+//Link to paper: http://modelai.gettysburg.edu/2013/cfr/cfr.pdf
+
+//Example: normal_form_cfr --game games/rps.txt --threads 4 --iterations 1000000 --batches 10
+//Settings come from flags or a config file (run with --help), and a JSON summary of the run is written at the end
+
+#include<bits/stdc++.h>
+#include <omp.h>
+#include "Rng.h"
+#include "Config.h"
+#include "Profiler.h"
+#include "RegretMatching.h"
+#include "UtilityKernels.h"
+#include "NormalFormGame.h"
+#include "NormalFormCFR.h"
+
+using namespace std;
+
+void writeJsonArray(ostream &os, const vector<double> &v){
+    os<<"[";
+    for(size_t i=0; i<v.size(); i++)
+        os<<(i>0 ? ", " : "")<<v[i];
+    os<<"]";
+}
+
+// Machine-readable summary of a run: settings, timing, Nash gap and average strategies
+bool writeSummary(const string &file, Config &config, int threads, long long iterations, double wallSeconds, vector<double> &nashConv, vector<vector<double>> &strategies, Profiler &profiler){
+    ofstream os(file);
+    os.precision(10);
+    os<<"{"<<endl;
+    os<<"  \"program\": \"normal_form_cfr\","<<endl;
+    os<<"  \"game\": \""<<config.get_string("game")<<"\","<<endl;
+    os<<"  \"seed\": "<<config.get_int("seed")<<","<<endl;
+    os<<"  \"threads\": "<<threads<<","<<endl;
+    os<<"  \"mode\": \""<<config.get_string("mode")<<"\","<<endl;
+    os<<"  \"rule\": \""<<config.get_string("rule")<<"\","<<endl;
+    os<<"  \"precision\": \""<<config.get_string("precision")<<"\","<<endl;
+    os<<"  \"iterations\": "<<iterations<<","<<endl;
+    os<<"  \"wall_seconds\": "<<wallSeconds<<","<<endl;
+    // the time of the Nash gap is not counted
+    double trainSeconds = profiler.seconds(0);
+    os<<"  \"iterations_per_second\": "<<(trainSeconds>0 ? iterations/trainSeconds : 0)<<","<<endl;
+    os<<"  \"nash_conv\": "; writeJsonArray(os, nashConv); os<<","<<endl;
+    os<<"  \"strategies\": [";
+    for(size_t p=0; p<strategies.size(); p++){
+        os<<(p>0 ? ", " : "");
+        writeJsonArray(os, strategies[p]);
+    }
+    os<<"],"<<endl;
+    os<<"  \"profile\": "; profiler.write_json(os, "  "); os<<endl;
+    os<<"}"<<endl;
+    os.close();
+    if(!os){
+        cout<<"Could not write "<<file<<endl;
+        return false;
+    }
+    return true;
+}
+
+// Trains with sums of type T; returns the exit code of the program
+template<class T>
+int run(Config &config, NormalFormGame &game, int threads){
+    long long iterations = config.get_int("iterations");
+    int batches = config.get_int("batches");
+    NormalFormCFR<T> cfr(game, config.get_int("seed"));
+    if(config.get_string("mode") == "expected")
+        cfr.setMode(NormalFormCFR<T>::Mode::expected);
+    else if(config.get_string("mode") != "sampled"){
+        cout<<"Invalid value \""<<config.get_string("mode")<<"\" for mode, expected one of sampled expected"<<endl;
+        return 1;
+    }
+    if(config.get_string("rule") == "cfr+")
+        cfr.setUpdateRule(NormalFormCFR<T>::UpdateRule::cfrPlus);
+    else if(config.get_string("rule") != "vanilla"){
+        cout<<"Invalid value \""<<config.get_string("rule")<<"\" for rule, expected one of vanilla cfr+"<<endl;
+        return 1;
+    }
+    Profiler profiler({"train", "nash_conv"});
+    vector<double> nashConv;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int b=0; b<batches; b++){
+        {
+            Profiler::Timer timer(profiler, 0, 0, iterations);
+            cfr.train(iterations, threads);
+        }
+        Profiler::Timer timer(profiler, 0, 1);
+        nashConv.push_back(cfr.nashConv(threads));
+        cout<<"Batch "<<b+1<<": Nash gap "<<nashConv.back()<<endl;
+    }
+    double wallSeconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    vector<vector<double>> strategies = cfr.averageStrategies();
+    int shown = config.get_int("show");
+    for(int p=0; p<game.players(); p++){
+        cout<<"Average strategy of player "<<p<<":";
+        for(int a=0; a<game.actions(p) && a<shown; a++)
+            cout<<" "<<strategies[p][a];
+        if(game.actions(p) > shown)
+            cout<<" ... ("<<game.actions(p)<<" actions)";
+        cout<<endl;
+    }
+    cout<<"Program Execution Time: "<<wallSeconds*1000<<" ms"<<endl;
+    string summary = config.get_string("summary");
+    if(!writeSummary(summary, config, threads, iterations*batches, wallSeconds, nashConv, strategies, profiler))
+        return 1;
+    cout<<"Summary written to "<<summary<<endl;
+    return 0;
+}
+
+int main(int argc, char** argv){
+
+Config config;
+config.add("game", Config::Kind::text, "", "game file");
+config.add("threads", Config::Kind::integer, to_string(omp_get_max_threads()), "number of OpenMP threads");
+config.set_range("threads", 1, INT_MAX);
+config.add("iterations", Config::Kind::integer, "1000000", "iterations per batch");
+config.set_range("iterations", 0, LLONG_MAX);
+config.add("batches", Config::Kind::integer, "10", "batches; the Nash gap is computed after each");
+config.set_range("batches", 0, INT_MAX);
+config.add("seed", Config::Kind::integer, to_string(time(0)), "seed of the run (default: the time)");
+config.add("mode", Config::Kind::text, "sampled", "sampled (one action per player per iteration) or expected (full expected utilities)");
+config.add("rule", Config::Kind::text, "vanilla", "update rule of the expected mode: vanilla or cfr+");
+config.add("precision", Config::Kind::text, "float", "type of the regret and strategy sums: float or double");
+config.add("show", Config::Kind::integer, "20", "actions of each player printed");
+config.set_range("show", 0, INT_MAX);
+config.add("summary", Config::Kind::text, "summary.json", "JSON summary file");
+if(!config.parse(argc, argv))
+    return 1;
+if(config.get_string("game").empty()){
+    cout<<"A game file is needed (--game)"<<endl;
+    config.usage(argv[0]);
+    return 1;
+}
+
+int thread_count = config.get_int("threads");
+omp_set_num_threads(thread_count);
+
+NormalFormGame game;
+if(!game.load(config.get_string("game")))
+    return 1;
+cout<<"Game with "<<game.players()<<" players and "<<game.profiles()<<" action profiles"<<endl;
+cout<<"Seed: "<<config.get_int("seed")<<endl;
+
+string precision = config.get_string("precision");
+if(precision == "float")
+    return run<float>(config, game, thread_count);
+if(precision == "double")
+    return run<double>(config, game, thread_count);
+cout<<"Invalid value \""<<precision<<"\" for precision, expected one of float double"<<endl;
+return 1;
+}
@@ -4,189 +4,157 @@
 
 //Parallelized version of cfr_rps.cpp written using OpenMP
 
+//The iterations are split in one chunk per thread. Every thread runs its chunk against its own
+//regret and strategy sums, starting from the shared regrets, and the sums of the threads are
+//added in thread order at the end, so that a run is reproducible for a given seed and thread count
+
+//Settings come from flags or a config file (run with --help), and a JSON summary of the run is written at the end
+
 #include<bits/stdc++.h>
 #include <omp.h>
+#include "Rng.h"
+#include "Config.h"
+#include "Profiler.h"
+#include "RegretMatching.h"
 
 using namespace std;
 
-// Returns the adjusted strategy after an iteration
-vector<vector<float>> getStrategy(vector<float> &regretSum, vector<float> &strategySum){
-    int actions = 3;
-    float normalizingSum =0;
-    vector<float> strategy = {0,0,0};
-    //NormalizingSum is the sum of positive regrets.
-    //This ensures do not 'over-adjust' and coverage to equilibrium
-    int i;
-    #pragma omp parallel for private(i) reduction(+: normalizingSum)
-    for(i=0; i< actions; i++){
-        if(regretSum[i]> 0)
-            strategy[i] = regretSum[i];
-        else 
-            strategy[i] = 0;
-        normalizingSum += strategy[i];
-    }
-    // This loop normalizes our update strategy
-    for(i=0; i< actions; i++) {
-        if(normalizingSum > 0)
-            strategy[i] = strategy[i]/normalizingSum;
-        else {
-            // Default to 33%
-            strategy[i] = 1.0 / actions;
-        }
-        strategySum[i] += strategy[i]; 
-    }
+// Regret and strategy sums of one player in one thread, on their own cache line
+struct alignas(64) Accumulator {
+    array<float,3> regretSum = {0,0,0};
+    array<float,3> strategySum = {0,0,0};
+};
 
-    vector<vector<float>> strategyStrategySum;
-    strategyStrategySum.push_back(strategy);
-    strategyStrategySum.push_back(strategySum);
-    return strategyStrategySum;
-}
+// payoff[b][a] is the utility of action a against action b:
+// Rock (0) beats Scissors (2), Paper (1) beats Rock, Scissors beat Paper
+const array<array<float,3>,3> payoff = {{{0, 1, -1}, {-1, 0, 1}, {1, -1, 0}}};
 
 //sum function
 float sum(vector<float> &arraySum){
-    float s=0; int i;
-    #pragma omp parallel for private(i) reduction(+: s)
-    for(i=0;i<arraySum.size();i++){
-        s+=arraySum[i];
-    }
-    return s;
+    return arraySum[0] + arraySum[1] + arraySum[2];
 }
 
-// Returns a random action according to the strategy
-
-int getAction(vector<float> &strategy){
-    float r = (float)rand() / (float)RAND_MAX;
-    if(r>= 0 && r< strategy[0])
-        return 0;
-    else if (r>=strategy[0] && r<(strategy[0]+strategy[1]))
-        return 1;
-    else if (r>=strategy[0] + strategy[1] && r<sum(strategy)) // Using the implemeted sum function
-        return 2;
-    else 
-        return 0;
+array<float,3> toArray(const vector<float> &v){
+    return {v[0], v[1], v[2]};
 }
 
+vector<float> toVector(const array<float,3> &a){
+    return {a[0], a[1], a[2]};
+}
 
-vector<float> train(int iterations, vector<float> &regretSum, vector<float> &oppStrategy) {
-    vector<int> actionUtility = {0,0,0};
-    vector<float> strategySum = {0,0,0};
-    int actions = 3; int i;
-    #pragma omp parallel for private(i)
-    for (i = 0; i< iterations; i++) {
-        // Retrieve Actions
-        vector<vector<float>> t = getStrategy(regretSum, strategySum);
-        vector<float> strategy = t[0];
-        vector<float> strategySum = t[1];
-        
-        float myaction = getAction(strategy);
-        // Define an arbitary opponent strategy from which to adjust
-        float otherAction = getAction(oppStrategy);
-        
-        // Opponent Chooses Scissors
-        if(otherAction == actions-1) {
-            // Utility(Rock) = 1
-            actionUtility[0] = 1;
-            // Utility(Paper) = -1
-            actionUtility[1] = -1;
-        // Opponent Chooses Rock
-        }
-        else if (otherAction == 0) {
-            // Utility(Scissors) = -1
-            actionUtility[actions -1] = -1;
-            // Utility(Paper) = 1
-            actionUtility[1] = 1;
-        // Opponent Chooses Paper
-        }
-        else {
-            // Utility(Rock) = -1
-            actionUtility[0] = -1;
-            // Utility(Scissors) = 1
-            actionUtility[2] = 1;
+// Number of iterations of thread t out of n threads
+inline long long chunk(long long iterations, int t, int n){
+    return iterations/n + (t < iterations%n ? 1 : 0);
+}
+
+// Trains against a fixed opponent strategy; returns the strategy sum and adds the regrets to regretSum
+vector<float> train(long long iterations, vector<float> &regretSum, vector<float> &oppStrategy, vector<Rng> &rngs) {
+    int threads = rngs.size();
+    vector<Accumulator> accumulators(threads);
+    const array<float,3> opp = toArray(oppStrategy);
+    int t;
+    #pragma omp parallel for private(t) schedule(static,1)
+    for (t = 0; t < threads; t++) {
+        Accumulator &a = accumulators[t];
+        Rng &rng = rngs[t];
+        a.regretSum = toArray(regretSum);
+        array<float,3> strategy;
+        long long n = chunk(iterations, t, threads);
+        for (long long i = 0; i < n; i++) {
+            // Retrieve Actions
+            getStrategy(a.regretSum, strategy, a.strategySum);
+            int myAction = getAction(strategy, rng);
+            // Define an arbitary opponent strategy from which to adjust
+            int otherAction = getAction(opp, rng);
+            // Add the regrets from this decision
+            addRegrets(a.regretSum, payoff[otherAction], payoff[otherAction][myAction]);
         }
-        int j;
-        #pragma omp parallel for private(j)
-        // Add the regrets from this decision
-        for(j=0; j< actions; j++) {
-            regretSum[j] += actionUtility[j] - actionUtility[myaction];
+    }
+    // Reduction in thread order
+    vector<float> start = regretSum;
+    vector<float> strategySum = {0,0,0};
+    for (t = 0; t < threads; t++) {
+        for (int k = 0; k < 3; k++) {
+            regretSum[k] += accumulators[t].regretSum[k] - start[k];
+            strategySum[k] += accumulators[t].strategySum[k];
         }
     }
     return strategySum;
 }
 
-vector<float> getAverageStrategy(int iterations, vector<float> &oppStrategy) {
-    int actions = 3;
+vector<float> getAverageStrategy(long long iterations, vector<float> &oppStrategy, vector<Rng> &rngs) {
     vector<float> regretSum={0,0,0};
-    vector<float> strategySum= train(iterations, regretSum , oppStrategy);
-    vector<float> avgStrategy= {0,0,0};
-    float normalizingSum = 0; int i;
-    #pragma omp parallel for private(i) reduction(+: normalizingSum)
-    for(i=0; i<actions; i++){
-        normalizingSum += strategySum[i];
-    }
+    vector<float> strategySum= train(iterations, regretSum , oppStrategy, rngs);
+    return toVector(averageStrategy(toArray(strategySum)));
+}
 
-    #pragma omp parallel for private(i)
-    for(i=0; i<actions; i++) {
-        if(normalizingSum > 0) {
-            avgStrategy[i] = strategySum[i] / normalizingSum;
-        }
-        else {
-            avgStrategy[i] = 1.0 / actions;
-        }
+
+// Update rules for train2Player, applied at the end of each iteration:
+// vanilla: plain regret matching, every iteration weighs the same in the average strategy
+// cfrPlus: regrets are floored at zero and iteration t weighs t in the average (CFR+)
+// discounted: positive regrets are scaled by t^alpha/(t^alpha+1), negative ones by
+// t^beta/(t^beta+1) and the strategy sum by (t/(t+1))^gamma (Discounted CFR)
+enum class UpdateRule { vanilla, cfrPlus, discounted };
+
+const float dcfrAlpha = 1.5, dcfrBeta = 0, dcfrGamma = 2;
+
+// Applies the update rule to the sums at the end of iteration t (counted from 1)
+void applyUpdateRule(UpdateRule rule, long long t, array<float,3> &regretSum, array<float,3> &strategySum){
+    if(rule == UpdateRule::vanilla)
+        return;
+    // CFR+ floors the regrets, and scaling the sum by t/(t+1) every iteration gives linear weights
+    float positive = 1, negative = 0, average = (float)t/(t+1);
+    if(rule == UpdateRule::discounted){
+        positive = pow(t,dcfrAlpha)/(pow(t,dcfrAlpha)+1);
+        negative = pow(t,dcfrBeta)/(pow(t,dcfrBeta)+1);
+        average = pow((float)t/(t+1),dcfrGamma);
+    }
+    for(int i=0; i<3; i++){
+        regretSum[i] *= regretSum[i] > 0 ? positive : negative;
+        strategySum[i] *= average;
     }
-    return avgStrategy;
 }
 
-
 // Two player training function
-vector<vector<float>> train2Player(int iterations, vector<float> &regretSum1, vector<float> &regretSum2, vector<float> &p2Strat) {
+vector<vector<float>> train2Player(long long iterations, vector<float> &regretSum1, vector<float> &regretSum2, vector<Rng> &rngs, UpdateRule rule) {
     // Adapt train function for two players
-    int actions = 3;
-    vector<int> actionUtility= {0,0,0};
-    vector<float> strategySum1 = {0,0,0};
-    vector<float> strategySum2 = {0,0,0};
-    int i;
-    #pragma omp parallel for private(i)
-    for(i=0; i< iterations; i++) {
-        // Retrieve Actions
-        vector<vector<float>>t1 = getStrategy(regretSum1, strategySum1);
-        vector<float> strategy1 = t1[0];
-        strategySum1 = t1[1];
-        float myaction = getAction(strategy1);
-        vector<vector<float>>t2 = getStrategy(regretSum2, p2Strat);
-        vector<float> strategy2 = t2[0];
-        strategySum2 = t2[1];
-        float otherAction = getAction(strategy2);
-
-        // Opponent Chooses scissors
-        if (otherAction == actions -1) {
-            // Utility(Rock) = 1
-            actionUtility[0] = 1;
-            // Utility(Paper) = -1
-            actionUtility[1] = -1;
-        }
-        // Opponent chooses Rock
-        else if (otherAction == 0) {
-            // Utility(Scissors) = -1
-            actionUtility[actions-1] = -1;
-            // Utility(Paper) = 1
-            actionUtility[1] = 1;
+    int threads = rngs.size();
+    vector<Accumulator> accumulators1(threads), accumulators2(threads);
+    int t;
+    #pragma omp parallel for private(t) schedule(static,1)
+    for (t = 0; t < threads; t++) {
+        Accumulator &a1 = accumulators1[t];
+        Accumulator &a2 = accumulators2[t];
+        Rng &rng = rngs[t];
+        a1.regretSum = toArray(regretSum1);
+        a2.regretSum = toArray(regretSum2);
+        array<float,3> strategy1, strategy2;
+        long long n = chunk(iterations, t, threads);
+        for (long long i = 0; i < n; i++) {
+            // Retrieve Actions
+            getStrategy(a1.regretSum, strategy1, a1.strategySum);
+            int myAction = getAction(strategy1, rng);
+            getStrategy(a2.regretSum, strategy2, a2.strategySum);
+            int otherAction = getAction(strategy2, rng);
+            // Add the regrets from this decision
+            addRegrets(a1.regretSum, payoff[otherAction], payoff[otherAction][myAction]);
+            addRegrets(a2.regretSum, payoff[myAction], payoff[myAction][otherAction]);
+            // The iterations are counted per thread
+            applyUpdateRule(rule, i+1, a1.regretSum, a1.strategySum);
+            applyUpdateRule(rule, i+1, a2.regretSum, a2.strategySum);
         }
-        // Opponent Chooses Paper
-        else {
-            // Utility(Rock) = -1
-            actionUtility[0] = -1;
-            // Utility(Scissors) = 1
-            actionUtility[2] = 1;
-        }
-
-        // Add the regrets from this decision 
-        #pragma omp parallel for private(i)
-        for(i=0 ; i< actions; i++){
-            regretSum1[i] += actionUtility[i] - actionUtility[myaction];
-            regretSum2[i] += -(actionUtility[i] - actionUtility[myaction]);
+    }
+    // Reduction in thread order
+    vector<float> start1 = regretSum1, start2 = regretSum2;
+    vector<float> strategySum1 = {0,0,0}, strategySum2 = {0,0,0};
+    for (t = 0; t < threads; t++) {
+        for (int k = 0; k < 3; k++) {
+            regretSum1[k] += accumulators1[t].regretSum[k] - start1[k];
+            regretSum2[k] += accumulators2[t].regretSum[k] - start2[k];
+            strategySum1[k] += accumulators1[t].strategySum[k];
+            strategySum2[k] += accumulators2[t].strategySum[k];
         }
     }
-
     vector<vector<float>> strategySum12;
     strategySum12.push_back(strategySum1);
     strategySum12.push_back(strategySum2);
@@ -195,16 +163,14 @@ vector<vector<float>> train2Player(int iterations, vector<float> &regretSum1, ve
 
 // Returns the Nash Equilibrium reached by two opponents throught Counterfactual Regret Minimisation:
 
-vector<vector<float>> RPStoNash(int iterations, vector<float> &oppStrat) {
+vector<vector<float>> RPStoNash(long long iterations, vector<Rng> &rngs, UpdateRule rule) {
     vector<float> regretSum1 ={0,0,0};
     vector<float> regretSum2 ={0,0,0};
-    vector<vector<float>> strats = train2Player(iterations, regretSum1, regretSum2, oppStrat);
+    vector<vector<float>> strats = train2Player(iterations, regretSum1, regretSum2, rngs, rule);
     
     float s1 = sum(strats[0]);
     float s2 = sum(strats[1]);
-    int i;
-    #pragma omp parallel for private(i)
-    for(i=0; i<3; i++) {
+    for(int i=0; i<3; i++) {
         if(s1>0){
             strats[0][i] = strats[0][i]/s1;
         }
@@ -216,31 +182,104 @@ vector<vector<float>> RPStoNash(int iterations, vector<float> &oppStrat) {
     return strats;
 }
 
-int main(){
+const char* ruleNames[] = {"vanilla", "cfr+", "discounted"};
+
+void writeJsonArray(ostream &os, const vector<float> &v){
+    os<<"[";
+    for(size_t i=0; i<v.size(); i++)
+        os<<(i>0 ? ", " : "")<<v[i];
+    os<<"]";
+}
+
+// Machine-readable summary of a run: settings, timing and the strategies found
+bool writeSummary(const string &file, unsigned long long seed, int threads, UpdateRule rule, long long iterations, double wallSeconds, double cpuSeconds, vector<float> &exploitative, vector<vector<float>> &nash, Profiler &profiler){
+    ofstream os(file);
+    os.precision(10);
+    os<<"{"<<endl;
+    os<<"  \"program\": \"rps_parallel\","<<endl;
+    os<<"  \"seed\": "<<seed<<","<<endl;
+    os<<"  \"threads\": "<<threads<<","<<endl;
+    os<<"  \"rule\": \""<<ruleNames[(int)rule]<<"\","<<endl;
+    os<<"  \"iterations\": "<<iterations<<","<<endl;
+    os<<"  \"wall_seconds\": "<<wallSeconds<<","<<endl;
+    os<<"  \"cpu_seconds\": "<<cpuSeconds<<","<<endl;
+    // both trainings run "iterations" iterations
+    os<<"  \"iterations_per_second\": "<<(wallSeconds>0 ? 2*iterations/wallSeconds : 0)<<","<<endl;
+    os<<"  \"exploitative_strategy\": "; writeJsonArray(os, exploitative); os<<","<<endl;
+    os<<"  \"nash_strategy_1\": "; writeJsonArray(os, nash[0]); os<<","<<endl;
+    os<<"  \"nash_strategy_2\": "; writeJsonArray(os, nash[1]); os<<","<<endl;
+    os<<"  \"profile\": "; profiler.write_json(os, "  "); os<<endl;
+    os<<"}"<<endl;
+    os.close();
+    if(!os){
+        cout<<"Could not write "<<file<<endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+
+Config config;
+config.add("threads", Config::Kind::integer, to_string(omp_get_max_threads()), "number of OpenMP threads");
+config.set_range("threads", 1, INT_MAX);
+config.add("iterations", Config::Kind::integer, "1000000", "iterations of each training");
+config.set_range("iterations", 0, LLONG_MAX);
+config.add("seed", Config::Kind::integer, "", "seed of the run (default: the time)");
+config.add("rule", Config::Kind::text, "vanilla", "update rule of the two player training: vanilla, cfr+ or discounted");
+config.add("summary", Config::Kind::text, "summary.json", "JSON summary file");
+if(!config.parse(argc, argv))
+    return 1;
 
-long long iterations= 1000000;
-// cout<<"Enter number of iteration: \n";
-// cin>>iterations;
-int thread_count= 4;
-cout<<"Enter number of threads: \n";
-cin>>thread_count;
+long long iterations = config.get_int("iterations");
+int thread_count = config.get_int("threads");
 
 omp_set_num_threads(thread_count);
 
-vector<float> oppStrat = {0.4,0.3,0.3}; clock_t time_req;
+// one generator per thread, all derived from the same seed
+unsigned long long seed = config.has("seed") ? config.get_int("seed") : time(0);
+cout<<"Seed: "<<seed<<endl;
+vector<Rng> rngs;
+for(int t=0; t<thread_count; t++){
+    rngs.push_back(Rng(seed,t));
+}
+
+// update rule of the two player training
+int ruleIndex = -1;
+for(int r=0; r<3; r++)
+    if(config.get_string("rule") == ruleNames[r])
+        ruleIndex = r;
+if(ruleIndex < 0){
+    cout<<"Invalid value \""<<config.get_string("rule")<<"\" for rule, expected one of vanilla cfr+ discounted"<<endl;
+    return 1;
+}
+UpdateRule rule = (UpdateRule)ruleIndex;
+
+vector<float> oppStrat = {0.4,0.3,0.3};
 cout<<"Opponent's Strategy: ";
 for(auto itr:oppStrat){
     cout<<itr<<" ";
 }
-time_req = clock();
-vector<float> ans = getAverageStrategy(1000000,oppStrat);
+// wall time of the two trainings; clock() would add up the CPU time of all threads
+Profiler profiler({"exploitative", "nash"});
+clock_t cpuStart = clock();
+chrono::steady_clock::time_point start = chrono::steady_clock::now();
+vector<float> ans;
+{
+    Profiler::Timer timer(profiler, 0, 0, iterations);
+    ans = getAverageStrategy(iterations,oppStrat,rngs);
+}
 cout<<"\nMaximally Exploitative Strategy: ";
 
 for(auto itr:ans){
     cout<<itr<<" ";
 }
 
-vector<vector<float>> rpsToNash = RPStoNash(1000000,oppStrat);
+vector<vector<float>> rpsToNash;
+{
+    Profiler::Timer timer(profiler, 0, 1, iterations);
+    rpsToNash = RPStoNash(iterations,rngs,rule);
+}
 cout<<"\nNash Equilibrium at: ";
 
 for(auto itr:rpsToNash[0]){
@@ -249,8 +288,14 @@ for(auto itr:rpsToNash[0]){
 for(auto itr:rpsToNash[1]){
     cout<<itr<<" ";
 }
-time_req = clock() - time_req;
-cout<<"\nProgram Execution Time: "<<time_req*1000/CLOCKS_PER_SEC<<" ms"<<endl;
+double wallSeconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+double cpuSeconds = (double)(clock()-cpuStart)/CLOCKS_PER_SEC;
+cout<<"\nProgram Execution Time: "<<wallSeconds*1000<<" ms (CPU time "<<cpuSeconds*1000<<" ms)"<<endl;
+
+string summary = config.get_string("summary");
+if(!writeSummary(summary, seed, thread_count, rule, iterations, wallSeconds, cpuSeconds, ans, rpsToNash, profiler))
+    return 1;
+cout<<"Summary written to "<<summary<<endl;
 
 return 0;
-}
\ No newline at end of file
+}
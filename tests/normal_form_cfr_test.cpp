@@ -0,0 +1,45 @@
+//Checks that the sampled mode of NormalFormCFR converges with several threads:
+//the Nash gap of the average strategies must go down over the batches, as it does on one thread
+
+//Usage: normal_form_cfr_test <game file>
+
+#include<bits/stdc++.h>
+#include <omp.h>
+#include "Rng.h"
+#include "RegretMatching.h"
+#include "UtilityKernels.h"
+#include "NormalFormGame.h"
+#include "NormalFormCFR.h"
+
+using namespace std;
+
+// Returns true if the Nash gap after the last batch is below maxGap and at most half the gap after the first batch
+bool converges(NormalFormGame &game, int threads, int batches, long long iterations, double maxGap){
+    NormalFormCFR<double> cfr(game, 1);
+    double first = 0, last = 0;
+    for(int b=0; b<batches; b++){
+        cfr.train(iterations, threads);
+        last = cfr.nashConv();
+        if(b == 0)
+            first = last;
+    }
+    bool ok = last <= maxGap && last <= first/2;
+    cout<<(ok ? "ok  " : "FAIL")<<" threads "<<threads<<": Nash gap "<<first<<" after batch 1, "<<last<<" after batch "<<batches<<endl;
+    return ok;
+}
+
+int main(int argc, char** argv){
+
+if(argc != 2){
+    cout<<"Usage: "<<argv[0]<<" <game file>"<<endl;
+    return 1;
+}
+NormalFormGame game;
+if(!game.load(argv[1]))
+    return 1;
+
+bool ok = true;
+for(int threads : {1, 2, 4, 8})
+    ok = converges(game, threads, 10, 100000, 0.005) && ok;
+return ok ? 0 : 1;
+}
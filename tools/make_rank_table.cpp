@@ -0,0 +1,109 @@
+/********************************************************************************
+ 
+ Build-time tool: converts ranks.csv into RankTable.h, the compact binary
+ rank table that CheckRank compiles in, so that the trainers do not read or
+ parse any file when they start.
+ 
+ Usage: make_rank_table ranks.csv RankTable.h
+ 
+ ranks.csv lists the 7462 distinct 5-card hands in the decreasing order of
+ rank, on one comma-separated line, each hand written with the characters
+ AKQJT98765432. In RankTable.h each hand is one 32-bit word holding the
+ indexes of its five card ranks (A=0, K=1, ..., 2=12), 4 bits each, first
+ card in the lowest bits, followed by a checksum of the words that CheckRank
+ verifies at compile time.
+ 
+ ********************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+
+using namespace std;
+
+const string rank_chars="AKQJT98765432";
+
+// FNV-1a over the words of the table; the same function is used by
+// CheckRank to check the table.
+unsigned long long checksum(const vector<unsigned> & hands){
+    unsigned long long h=0xCBF29CE484222325ULL;
+    for(unsigned w : hands){
+        h^=w;
+        h*=0x100000001B3ULL;
+    }
+    return h;
+}
+
+int fail(const string & message){
+    cerr << "make_rank_table: " << message << endl;
+    return 1;
+}
+
+int main(int argc, char ** argv){
+    if(argc!=3)
+        return fail("usage: make_rank_table ranks.csv RankTable.h");
+    ifstream is(argv[1]);
+    if(!is)
+        return fail(string("cannot open ")+argv[1]);
+    string str;
+    getline(is,str);
+    vector<unsigned> hands;
+    size_t i=0;
+    while(i<str.size()){
+        size_t j=str.find(',',i);
+        if(j==string::npos)
+            j=str.size();
+        string entry=str.substr(i,j-i);
+        if(!entry.empty()&&entry.back()=='\r')
+            entry.pop_back();
+        if(entry.size()!=5)
+            return fail("entry "+to_string(hands.size())+" of "+argv[1]+" is \""+entry+"\", expected 5 cards");
+        unsigned word=0;
+        for(int k=0;k<5;++k){
+            size_t r=rank_chars.find(entry[k]);
+            if(r==string::npos)
+                return fail("entry "+to_string(hands.size())+" of "+argv[1]+" has an unknown card rank '"+entry[k]+"'");
+            word|=r<<(4*k);
+        }
+        hands.push_back(word);
+        i=j+1;
+    }
+    if(hands.size()!=7462)
+        return fail(string(argv[1])+" has "+to_string(hands.size())+" hands, expected 7462");
+    ofstream os(argv[2]);
+    if(!os)
+        return fail(string("cannot write ")+argv[2]);
+    os << "/********************************************************************************\n";
+    os << " \n";
+    os << " Rank table generated from ranks.csv by tools/make_rank_table; do not edit.\n";
+    os << " \n";
+    os << " ********************************************************************************/\n\n";
+    os << "#define RANK_TABLE 1\n\n";
+    os << "using namespace std;\n\n";
+    os << "struct RankTable{\n";
+    os << "    \n";
+    os << "    static constexpr int size=" << hands.size() << ";\n";
+    os << "    \n";
+    os << "    // five 4-bit card rank indexes per hand, in the order of ranks.csv\n";
+    os << "    static constexpr unsigned hands[" << hands.size() << "]={";
+    for(size_t k=0;k<hands.size();++k){
+        if(k%12==0)
+            os << "\n        ";
+        char buffer[16];
+        snprintf(buffer,sizeof(buffer),"0x%05X",hands[k]);
+        os << buffer << (k+1<hands.size() ? "," : "");
+    }
+    os << "\n    };\n";
+    os << "    \n";
+    char buffer[32];
+    snprintf(buffer,sizeof(buffer),"0x%016llXULL",checksum(hands));
+    os << "    static constexpr unsigned long long checksum=" << buffer << ";\n";
+    os << "    \n";
+    os << "};\n";
+    os.close();
+    if(!os)
+        return fail(string("cannot write ")+argv[2]);
+    return 0;
+}